@@ -0,0 +1,571 @@
+#ifndef __TALGORITHMS_HH
+#define __TALGORITHMS_HH
+//
+//  Project : ThreadPool
+//  File    : TAlgorithms.hh
+//  Author  : Ronald Kriemann
+//  Purpose : parallel versions of STL algorithms using a thread pool
+//
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "TThreadPool.hh"
+
+namespace ThreadPool
+{
+
+namespace algorithms
+{
+
+//! @cond
+
+namespace detail
+{
+
+////////////////////////////////////////////////////////////
+//
+// parallel execution of a function on index ranges: chunks are
+// claimed by jobs and by the calling thread, which therefore never
+// waits for jobs not yet started (and may be a thread of the pool)
+//
+////////////////////////////////////////////////////////////
+
+template < typename Body >
+class TRangeTask
+{
+public:
+    // function object, called for index ranges [begin,end)
+    Body &           body;
+
+    // size of range, size and number of chunks
+    const size_t     n, chunk, nchunks;
+
+    // next chunk to handle and number of handled chunks
+    volatile size_t  next, done;
+
+    // number of references (calling thread and jobs)
+    volatile int     refs;
+
+    // signals all chunks done
+    TCondition       cond;
+
+public:
+    TRangeTask ( Body &        abody,
+                 const size_t  an,
+                 const size_t  achunk,
+                 const int     arefs )
+            : body( abody ), n( an ), chunk( achunk ), nchunks( ( an + achunk - 1 ) / achunk ),
+              next( 0 ), done( 0 ), refs( arefs )
+    {}
+
+    // handle chunks until all are claimed
+    void  run ()
+    {
+        while ( true )
+        {
+            const size_t  c = atomic_add( next, size_t(1) ) - 1;
+
+            if ( c >= nchunks )
+                break;
+
+            const size_t  begin = c * chunk;
+
+            body( begin, std::min( n, begin + chunk ) );
+
+            if ( atomic_add( done, size_t(1) ) == nchunks )
+            {
+                TScopedLock  lock( cond );
+
+                cond.broadcast();
+            }// if
+        }// while
+    }
+
+    // drop reference, delete task if last
+    void  unref ()
+    {
+        if ( atomic_add( refs, -1 ) == 0 )
+            delete this;
+    }
+};
+
+template < typename Body >
+class TRangeJob : public TPool::TJob
+{
+protected:
+    // task to handle (NULL after execution)
+    TRangeTask< Body > *  _task;
+
+public:
+    TRangeJob ( TRangeTask< Body > *  task ) : _task( task ) {}
+
+    // job was rejected or dropped without execution: release task
+    ~TRangeJob ()
+    {
+        if ( _task != NULL )
+            _task->unref();
+    }
+    
+    void run ( void * )
+    {
+        _task->run();
+        _task->unref();
+        _task = NULL;
+    }
+};
+
+//
+// return size of chunks for range of size n (about four chunks per thread)
+//
+inline size_t
+chunk_size ( const TPool &  pool,
+             const size_t   n,
+             const size_t   grain )
+{
+    const size_t  nchunks = 4 * std::max( pool.max_parallel(), 1u );
+    const size_t  chunk   = ( n + nchunks - 1 ) / nchunks;
+
+    return std::max( chunk, std::max( grain, size_t(1) ) );
+}
+
+//
+// call body for all chunks of size chunk of [0,n) in parallel
+//
+template < typename Body >
+void
+parallel_range ( TPool &       pool,
+                 const size_t  n,
+                 const size_t  chunk,
+                 Body &        body )
+{
+    const size_t  nchunks = ( n + chunk - 1 ) / chunk;
+
+    if ( nchunks == 0 )
+        return;
+
+    if (( nchunks == 1 ) || pool.sequential() || ( pool.max_parallel() == 0 ))
+    {
+        for ( size_t  begin = 0; begin < n; begin += chunk )
+            body( begin, std::min( n, begin + chunk ) );
+
+        return;
+    }// if
+
+    const size_t          njobs = std::min( size_t( pool.max_parallel() ), nchunks - 1 );
+    TRangeTask< Body > *  task  = new TRangeTask< Body >( body, n, chunk, int( njobs + 1 ) );
+
+    for ( size_t  i = 0; i < njobs; i++ )
+    {
+        TRangeJob< Body > *  job = new TRangeJob< Body >( task );
+        
+        // rejected jobs are not deleted by the pool (but release the task)
+        if ( ! pool.run( job, NULL, true ) )
+            delete job;
+    }// for
+
+    task->run();
+
+    {
+        TScopedLock  lock( task->cond );
+
+        while ( atomic_load( task->done ) < task->nchunks )
+            task->cond.wait();
+    }
+
+    task->unref();
+}
+
+////////////////////////////////////////////////////////////
+//
+// bodies of algorithms
+//
+////////////////////////////////////////////////////////////
+
+template < typename RandomIt, typename Function >
+struct TForEach
+{
+    RandomIt    first;
+    Function &  f;
+
+    TForEach ( RandomIt  afirst, Function &  af ) : first( afirst ), f( af ) {}
+
+    void operator () ( const size_t  begin, const size_t  end )
+    {
+        std::for_each( first + begin, first + end, f );
+    }
+};
+
+template < typename RandomIt, typename OutputIt, typename UnaryOp >
+struct TTransform
+{
+    RandomIt    first;
+    OutputIt    out;
+    UnaryOp &   op;
+
+    TTransform ( RandomIt  afirst, OutputIt  aout, UnaryOp &  aop )
+            : first( afirst ), out( aout ), op( aop )
+    {}
+
+    void operator () ( const size_t  begin, const size_t  end )
+    {
+        std::transform( first + begin, first + end, out + begin, op );
+    }
+};
+
+template < typename RandomIt, typename Predicate >
+struct TCountIf
+{
+    RandomIt                 first;
+    Predicate &              pred;
+    std::vector< char > &    flags;
+    std::vector< size_t > &  counts;
+    const size_t             chunk;
+
+    TCountIf ( RandomIt  afirst, Predicate &  apred,
+               std::vector< char > &  aflags, std::vector< size_t > &  acounts,
+               const size_t  achunk )
+            : first( afirst ), pred( apred ), flags( aflags ), counts( acounts ), chunk( achunk )
+    {}
+
+    void operator () ( const size_t  begin, const size_t  end )
+    {
+        size_t  count = 0;
+
+        for ( size_t  i = begin; i < end; i++ )
+        {
+            flags[i] = ( pred( first[i] ) ? 1 : 0 );
+            count   += flags[i];
+        }// for
+
+        counts[ begin / chunk ] = count;
+    }
+};
+
+template < typename RandomIt, typename OutputIt >
+struct TCopyFlagged
+{
+    RandomIt                       first;
+    OutputIt                       out;
+    const std::vector< char > &    flags;
+    const std::vector< size_t > &  offsets;
+    const size_t                   chunk;
+
+    TCopyFlagged ( RandomIt  afirst, OutputIt  aout,
+                   const std::vector< char > &  aflags, const std::vector< size_t > &  aoffsets,
+                   const size_t  achunk )
+            : first( afirst ), out( aout ), flags( aflags ), offsets( aoffsets ), chunk( achunk )
+    {}
+
+    void operator () ( const size_t  begin, const size_t  end )
+    {
+        OutputIt  o = out + offsets[ begin / chunk ];
+
+        for ( size_t  i = begin; i < end; i++ )
+        {
+            if ( flags[i] )
+            {
+                *o = first[i];
+                ++o;
+            }// if
+        }// for
+    }
+};
+
+template < typename RandomIt, typename Compare >
+struct TSortChunk
+{
+    RandomIt    first;
+    Compare &   comp;
+    const bool  stable;
+
+    TSortChunk ( RandomIt  afirst, Compare &  acomp, const bool  astable )
+            : first( afirst ), comp( acomp ), stable( astable )
+    {}
+
+    void operator () ( const size_t  begin, const size_t  end )
+    {
+        if ( stable ) std::stable_sort( first + begin, first + end, comp );
+        else          std::sort(        first + begin, first + end, comp );
+    }
+};
+
+template < typename SrcIt, typename DstIt >
+struct TCopy
+{
+    SrcIt  src;
+    DstIt  dst;
+
+    TCopy ( SrcIt  asrc, DstIt  adst ) : src( asrc ), dst( adst ) {}
+
+    void operator () ( const size_t  begin, const size_t  end )
+    {
+        std::copy( src + begin, src + end, dst + begin );
+    }
+};
+
+//
+// return number of elements of A in first k elements of stable merge of A and B
+// (elements of A precede equal elements of B)
+//
+template < typename It, typename Compare >
+size_t
+co_rank ( const size_t  k,
+          It            a, const size_t  na,
+          It            b, const size_t  nb,
+          Compare &     comp )
+{
+    size_t  lo = ( k > nb ? k - nb : 0 );
+    size_t  hi = std::min( k, na );
+
+    while ( lo < hi )
+    {
+        const size_t  i = ( lo + hi ) / 2;
+        const size_t  j = k - i;
+
+        // a[i] belongs before b[j-1]: take more of A
+        if (( j > 0 ) && ( i < na ) && ! comp( b[j-1], a[i] ))
+            lo = i + 1;
+        else
+            hi = i;
+    }// while
+
+    return lo;
+}
+
+//
+// merge sorted runs of size width of src into dst in parallel; the
+// output is split into pieces of size chunk, each merged independently
+//
+template < typename SrcIt, typename DstIt, typename Compare >
+struct TMergeRuns
+{
+    SrcIt         src;
+    DstIt         dst;
+    const size_t  n, width;
+    Compare &     comp;
+
+    TMergeRuns ( SrcIt  asrc, DstIt  adst, const size_t  an, const size_t  awidth, Compare &  acomp )
+            : src( asrc ), dst( adst ), n( an ), width( awidth ), comp( acomp )
+    {}
+
+    void operator () ( const size_t  begin, const size_t  end )
+    {
+        size_t  pos = begin;
+
+        // piece may span several pairs of runs
+        while ( pos < end )
+        {
+            const size_t  start = ( pos / ( 2 * width ) ) * ( 2 * width );
+            const size_t  mid   = std::min( n, start + width );
+            const size_t  stop  = std::min( n, start + 2 * width );
+            const size_t  last  = std::min( end, stop );
+            const size_t  na    = mid - start;
+            const size_t  nb    = stop - mid;
+            const size_t  i0    = co_rank( pos  - start, src + start, na, src + mid, nb, comp );
+            const size_t  i1    = co_rank( last - start, src + start, na, src + mid, nb, comp );
+            const size_t  j0    = ( pos  - start ) - i0;
+            const size_t  j1    = ( last - start ) - i1;
+
+            std::merge( src + start + i0, src + start + i1,
+                        src + mid   + j0, src + mid   + j1,
+                        dst + pos, comp );
+
+            pos = last;
+        }// while
+    }
+};
+
+//
+// parallel merge sort: sort chunks, then merge pairs of runs
+//
+template < typename RandomIt, typename Compare >
+void
+merge_sort ( TPool &     pool,
+             RandomIt    first,
+             RandomIt    last,
+             Compare     comp,
+             const bool  stable )
+{
+    typedef typename std::iterator_traits< RandomIt >::value_type  value_t;
+    typedef typename std::vector< value_t >::iterator              buf_it;
+
+    const size_t  n     = last - first;
+    const size_t  chunk = chunk_size( pool, n, 4096 );
+
+    TSortChunk< RandomIt, Compare >  sort_chunk( first, comp, stable );
+
+    parallel_range( pool, n, chunk, sort_chunk );
+
+    if ( chunk >= n )
+        return;
+
+    std::vector< value_t >  buf( n );
+    bool                    in_buf = false;
+
+    for ( size_t  width = chunk; width < n; width *= 2 )
+    {
+        if ( in_buf )
+        {
+            TMergeRuns< buf_it, RandomIt, Compare >  merge( buf.begin(), first, n, width, comp );
+
+            parallel_range( pool, n, chunk, merge );
+        }// if
+        else
+        {
+            TMergeRuns< RandomIt, buf_it, Compare >  merge( first, buf.begin(), n, width, comp );
+
+            parallel_range( pool, n, chunk, merge );
+        }// else
+
+        in_buf = ! in_buf;
+    }// for
+
+    if ( in_buf )
+    {
+        TCopy< buf_it, RandomIt >  copy( buf.begin(), first );
+
+        parallel_range( pool, n, chunk, copy );
+    }// if
+}
+
+}// namespace detail
+
+//! @endcond
+
+////////////////////////////////////////////////////////////
+//
+// parallel algorithms (on random access iterators)
+//
+////////////////////////////////////////////////////////////
+
+//! apply \a f to all elements of [\a first,\a last) using \a pool
+//! (in unspecified order)
+template < typename RandomIt, typename Function >
+void
+for_each ( TPool &   pool,
+           RandomIt  first,
+           RandomIt  last,
+           Function  f )
+{
+    const size_t                              n = last - first;
+    detail::TForEach< RandomIt, Function >    body( first, f );
+
+    detail::parallel_range( pool, n, detail::chunk_size( pool, n, 1 ), body );
+}
+
+//! store \a op applied to all elements of [\a first,\a last) in range
+//! starting at \a out using \a pool; return end of output range
+template < typename RandomIt, typename OutputIt, typename UnaryOp >
+OutputIt
+transform ( TPool &   pool,
+            RandomIt  first,
+            RandomIt  last,
+            OutputIt  out,
+            UnaryOp   op )
+{
+    const size_t                                       n = last - first;
+    detail::TTransform< RandomIt, OutputIt, UnaryOp >  body( first, out, op );
+
+    detail::parallel_range( pool, n, detail::chunk_size( pool, n, 1 ), body );
+
+    return out + n;
+}
+
+//! copy all elements of [\a first,\a last) satisfying \a pred to range
+//! starting at \a out, keeping their order, using \a pool (two passes:
+//! count per chunk, then copy to offsets); return end of output range
+template < typename RandomIt, typename OutputIt, typename Predicate >
+OutputIt
+copy_if ( TPool &    pool,
+          RandomIt   first,
+          RandomIt   last,
+          OutputIt   out,
+          Predicate  pred )
+{
+    const size_t           n       = last - first;
+    const size_t           chunk   = detail::chunk_size( pool, n, 1024 );
+    const size_t           nchunks = ( n + chunk - 1 ) / chunk;
+    std::vector< char >    flags( n );
+    std::vector< size_t >  offsets( nchunks + 1, 0 );
+
+    // count selected elements per chunk
+    detail::TCountIf< RandomIt, Predicate >  count( first, pred, flags, offsets, chunk );
+
+    detail::parallel_range( pool, n, chunk, count );
+
+    // offsets of chunks in output
+    size_t  sum = 0;
+
+    for ( size_t  i = 0; i < nchunks; i++ )
+    {
+        const size_t  c = offsets[i];
+
+        offsets[i] = sum;
+        sum       += c;
+    }// for
+
+    // copy selected elements
+    detail::TCopyFlagged< RandomIt, OutputIt >  copy( first, out, flags, offsets, chunk );
+
+    detail::parallel_range( pool, n, chunk, copy );
+
+    return out + sum;
+}
+
+//! sort [\a first,\a last) with respect to \a comp using \a pool
+//! (parallel merge sort)
+template < typename RandomIt, typename Compare >
+void
+sort ( TPool &   pool,
+       RandomIt  first,
+       RandomIt  last,
+       Compare   comp )
+{
+    detail::merge_sort( pool, first, last, comp, false );
+}
+
+//! sort [\a first,\a last) in ascending order using \a pool
+template < typename RandomIt >
+void
+sort ( TPool &   pool,
+       RandomIt  first,
+       RandomIt  last )
+{
+    typedef typename std::iterator_traits< RandomIt >::value_type  value_t;
+
+    detail::merge_sort( pool, first, last, std::less< value_t >(), false );
+}
+
+//! sort [\a first,\a last) with respect to \a comp using \a pool,
+//! keeping the order of equal elements
+template < typename RandomIt, typename Compare >
+void
+stable_sort ( TPool &   pool,
+              RandomIt  first,
+              RandomIt  last,
+              Compare   comp )
+{
+    detail::merge_sort( pool, first, last, comp, true );
+}
+
+//! sort [\a first,\a last) in ascending order using \a pool,
+//! keeping the order of equal elements
+template < typename RandomIt >
+void
+stable_sort ( TPool &   pool,
+              RandomIt  first,
+              RandomIt  last )
+{
+    typedef typename std::iterator_traits< RandomIt >::value_type  value_t;
+
+    detail::merge_sort( pool, first, last, std::less< value_t >(), true );
+}
+
+}// namespace algorithms
+
+}// namespace ThreadPool
+
+#endif  // __TALGORITHMS_HH
@@ -0,0 +1,194 @@
+//
+//  Project : ThreadPool
+//  File    : TArena.cc
+//  Author  : Ronald Kriemann
+//  Purpose : arena (bump) allocator for temporary memory of jobs
+//
+
+#include <stdlib.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <iostream>
+
+#include "TArena.hh"
+
+namespace ThreadPool
+{
+
+namespace
+{
+
+// size of chunk header (keeps memory of chunk aligned to cache lines)
+const size_t  HEADER_SIZE    = 64;
+
+// size of huge pages (transparent huge pages on x86-64 and arm64)
+const size_t  HUGE_PAGE_SIZE = 2*1024*1024;
+
+}// namespace anonymous
+
+//
+// constructor and destructor
+//
+TArena::TArena ( const size_t  chunk_size,
+                 const bool    huge_pages )
+        : _chunks( NULL ), _pos( NULL ), _end( NULL ),
+          _chunk_size( chunk_size ), _huge_pages( huge_pages ),
+          _used( 0 ), _peak( 0 )
+{}
+
+TArena::~TArena ()
+{
+    release();
+}
+
+//
+// release all allocated memory at once
+//
+void
+TArena::reset ()
+{
+    if ( _used > _peak )
+        _peak = _used;
+    
+    _used = 0;
+    
+    if ( _chunks == NULL )
+        return;
+
+    if ( _chunks->next != NULL )
+    {
+        // replace chunks by single chunk to avoid further chunk allocations
+        const size_t  size = capacity();
+
+        release();
+        _chunks = new_chunk( size );
+
+        if ( _chunks == NULL )
+            return;
+    }// if
+
+    _pos = reinterpret_cast< char * >( _chunks ) + HEADER_SIZE;
+    _end = reinterpret_cast< char * >( _chunks ) + _chunks->size;
+}
+
+//
+// release all chunks
+//
+void
+TArena::release ()
+{
+    while ( _chunks != NULL )
+    {
+        TChunk *  next = _chunks->next;
+
+        free_chunk( _chunks );
+        _chunks = next;
+    }// while
+
+    _pos  = _end = NULL;
+    _used = 0;
+}
+
+//
+// return size of all chunks
+//
+size_t
+TArena::capacity () const
+{
+    size_t  size = 0;
+
+    for ( TChunk *  chunk = _chunks; chunk != NULL; chunk = chunk->next )
+        size += chunk->size;
+
+    return size;
+}
+
+//
+// allocate memory in new chunk
+//
+void *
+TArena::allocate_chunk ( const size_t  n,
+                         const size_t  align )
+{
+    const size_t  size  = HEADER_SIZE + n + align;
+    TChunk *      chunk = new_chunk( size > _chunk_size ? size : _chunk_size );
+
+    if ( chunk == NULL )
+        throw std::bad_alloc();
+
+    chunk->next = _chunks;
+    _chunks     = chunk;
+    _pos        = reinterpret_cast< char * >( chunk ) + HEADER_SIZE;
+    _end        = reinterpret_cast< char * >( chunk ) + chunk->size;
+
+    return allocate( n, align );
+}
+
+//
+// return new chunk
+//
+TArena::TChunk *
+TArena::new_chunk ( const size_t  size )
+{
+    TChunk *  chunk = NULL;
+    size_t    csize = size;
+    bool      mapped = false;
+    
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if ( _huge_pages )
+    {
+        // round up to multiple of huge page size and ask for backing by
+        // (transparent) huge pages
+        csize = (( size + HUGE_PAGE_SIZE - 1 ) / HUGE_PAGE_SIZE ) * HUGE_PAGE_SIZE;
+
+        void *  p = mmap( NULL, csize, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+        if ( p != MAP_FAILED )
+        {
+            if ( madvise( p, csize, MADV_HUGEPAGE ) != 0 )
+                std::cerr << "(TArena) new_chunk : madvise failed" << std::endl;
+            
+            chunk  = static_cast< TChunk * >( p );
+            mapped = true;
+        }// if
+    }// if
+#endif
+
+    if ( chunk == NULL )
+    {
+        csize = size;
+        chunk = static_cast< TChunk * >( malloc( csize ) );
+
+        if ( chunk == NULL )
+            return NULL;
+    }// if
+
+    chunk->next   = NULL;
+    chunk->size   = csize;
+    chunk->mapped = mapped;
+
+    return chunk;
+}
+
+//
+// release chunk
+//
+void
+TArena::free_chunk ( TChunk *  chunk )
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if ( chunk->mapped )
+    {
+        munmap( chunk, chunk->size );
+        return;
+    }// if
+#endif
+
+    free( chunk );
+}
+
+}// namespace ThreadPool
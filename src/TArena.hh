@@ -0,0 +1,189 @@
+#ifndef __TARENA_HH
+#define __TARENA_HH
+//
+//  Project : ThreadPool
+//  File    : TArena.hh
+//  Author  : Ronald Kriemann
+//  Purpose : arena (bump) allocator for temporary memory of jobs
+//
+
+#include <cstddef>
+#include <new>
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TArena
+//! \brief  allocates memory by advancing a pointer in large chunks;
+//!         memory is only released by "reset", which keeps the chunks
+//!         for further allocations (not thread-safe)
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TArena
+{
+protected:
+    //! @cond
+
+    // header of a chunk of memory, followed by the memory itself
+    struct TChunk
+    {
+        TChunk *  next;
+        size_t    size;
+        bool      mapped;
+    };
+
+    // list of chunks, current chunk first
+    TChunk *      _chunks;
+
+    // start and end of free memory in current chunk
+    char *        _pos;
+    char *        _end;
+
+    // minimal size of chunks
+    size_t        _chunk_size;
+
+    // use huge pages for chunks
+    bool          _huge_pages;
+
+    // allocated bytes since last reset and maximum of it
+    size_t        _used;
+    size_t        _peak;
+
+    // prevent copy operations
+    TArena ( const TArena & );
+    TArena & operator = ( const TArena & );
+
+    //! @endcond
+
+public:
+    /////////////////////////////////////////////////
+    //
+    // constructor and destructor
+    //
+
+    //! construct arena with chunks of at least \a chunk_size bytes, which
+    //! are (if possible) backed by huge pages if \a huge_pages is true
+    TArena ( const size_t  chunk_size = 1024*1024,
+             const bool    huge_pages = false );
+
+    //! release all memory
+    ~TArena ();
+
+    /////////////////////////////////////////////////
+    //
+    // memory management
+    //
+
+    //! return \a n bytes aligned to \a align (power of two)
+    void *  allocate ( const size_t  n,
+                       const size_t  align = 16 )
+    {
+        char *  p = reinterpret_cast< char * >(( reinterpret_cast< size_t >( _pos ) + align - 1 ) & ~( align - 1 ));
+
+        if (( _pos == NULL ) || ( p + n > _end ))
+            return allocate_chunk( n, align );
+
+        _pos   = p + n;
+        _used += n;
+
+        return p;
+    }
+
+    //! release all allocated memory at once; if more than one chunk was
+    //! used, they are replaced by a single chunk of the combined size
+    void    reset    ();
+
+    //! release all chunks, e.g. return memory to the system
+    void    release  ();
+
+    //! return number of bytes allocated since last reset
+    size_t  used     () const { return _used; }
+
+    //! return maximal number of bytes allocated between resets
+    size_t  peak     () const { return ( _used > _peak ? _used : _peak ); }
+
+    //! return size of all chunks
+    size_t  capacity () const;
+
+protected:
+    //! @cond
+
+    // allocate memory in new chunk
+    void *  allocate_chunk ( const size_t  n,
+                             const size_t  align );
+
+    // return new chunk of at least size bytes (including header)
+    TChunk *  new_chunk    ( const size_t  size );
+
+    // release chunk
+    void      free_chunk   ( TChunk *  chunk );
+
+    //! @endcond
+};
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TArenaAllocator
+//! \brief  STL allocator using a TArena; deallocation is a no-op
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+template < typename T >
+class TArenaAllocator
+{
+public:
+    typedef T                value_type;
+    typedef T *              pointer;
+    typedef const T *        const_pointer;
+    typedef T &              reference;
+    typedef const T &        const_reference;
+    typedef size_t           size_type;
+    typedef std::ptrdiff_t   difference_type;
+
+    template < typename U >
+    struct rebind { typedef TArenaAllocator< U >  other; };
+
+    //! @cond
+    TArena *  _arena;
+    //! @endcond
+
+public:
+    //! construct allocator for \a arena
+    explicit TArenaAllocator ( TArena *  arena ) : _arena( arena ) {}
+
+    //! copy allocator for other type
+    template < typename U >
+    TArenaAllocator ( const TArenaAllocator< U > &  a ) : _arena( a._arena ) {}
+
+    pointer        address    ( reference        x ) const { return & x; }
+    const_pointer  address    ( const_reference  x ) const { return & x; }
+
+    //! return memory for \a n objects
+    pointer        allocate   ( size_type     n,
+                                const void *  = 0 )
+    {
+        return static_cast< pointer >( _arena->allocate( n * sizeof(T), __alignof__( T ) ) );
+    }
+
+    //! memory is released by TArena::reset
+    void           deallocate ( pointer, size_type ) {}
+
+    size_type      max_size   () const { return size_t(-1) / sizeof(T); }
+
+    void           construct  ( pointer  p, const T &  val ) { new( p ) T( val ); }
+    void           destroy    ( pointer  p )                 { p->~T(); }
+
+    bool           operator == ( const TArenaAllocator &  a ) const { return _arena == a._arena; }
+    bool           operator != ( const TArenaAllocator &  a ) const { return _arena != a._arena; }
+};
+
+}// namespace ThreadPool
+
+#endif  // __TARENA_HH
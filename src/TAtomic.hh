@@ -0,0 +1,67 @@
+#ifndef __TATOMIC_HH
+#define __TATOMIC_HH
+//
+//  Project : ThreadPool
+//  File    : TAtomic.hh
+//  Author  : Ronald Kriemann
+//  Purpose : atomic operations on integers (wrappers for compiler intrinsics)
+//
+
+namespace ThreadPool
+{
+
+//! size of a cache line in bytes (upper bound for common processors),
+//! e.g. for separating data written by different threads
+const unsigned int  CACHE_LINE_SIZE = 64;
+
+//! return value of \a v (with acquire semantics)
+template < typename T >
+inline T     atomic_load  ( const volatile T &  v )
+{
+    return __atomic_load_n( & v, __ATOMIC_ACQUIRE );
+}
+
+//! set \a v to \a n (with release semantics)
+template < typename T >
+inline void  atomic_store ( volatile T &  v, const T  n )
+{
+    __atomic_store_n( & v, n, __ATOMIC_RELEASE );
+}
+
+//! add \a n to \a v and return new value
+template < typename T >
+inline T     atomic_add   ( volatile T &  v, const T  n )
+{
+    return __atomic_add_fetch( & v, n, __ATOMIC_ACQ_REL );
+}
+
+//! set \a v to \a n and return previous value
+template < typename T >
+inline T     atomic_exchange ( volatile T &  v, const T  n )
+{
+    return __atomic_exchange_n( & v, n, __ATOMIC_ACQ_REL );
+}
+
+//! set \a v to \a n if it equals \a old, return true on success
+template < typename T >
+inline bool  atomic_cas   ( volatile T &  v, T  old, const T  n )
+{
+    return __atomic_compare_exchange_n( & v, & old, n, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+}
+
+//! hint to the processor that the calling thread is spinning
+inline void  cpu_relax    ()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__ ( "yield" ::: "memory" );
+#else
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+#endif
+}
+
+}// namespace ThreadPool
+
+#endif  // __TATOMIC_HH
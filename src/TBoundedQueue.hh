@@ -0,0 +1,165 @@
+#ifndef __TBOUNDEDQUEUE_HH
+#define __TBOUNDEDQUEUE_HH
+//
+//  Project : ThreadPool
+//  File    : TBoundedQueue.hh
+//  Author  : Ronald Kriemann
+//  Purpose : bounded lock-free queue for multiple producers and consumers
+//
+
+#include <cstddef>
+
+#include "TAtomic.hh"
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TBoundedQueue
+//! \brief  FIFO queue of fixed capacity without locks: each cell holds
+//!         a sequence number telling producers and consumers whether the
+//!         cell is free or filled in the current round of the ring buffer
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+template < typename T >
+class TBoundedQueue
+{
+protected:
+    //! @cond
+
+    // cell of ring buffer
+    struct TCell
+    {
+        volatile size_t  seq;
+        T                data;
+    };
+
+    // ring buffer and mask for cell index (capacity is power of two)
+    TCell *          _cells;
+    size_t           _mask;
+
+    // position of next push and pop (on separate cache lines)
+    char             _pad0[ CACHE_LINE_SIZE ];
+    volatile size_t  _push_pos;
+    char             _pad1[ CACHE_LINE_SIZE ];
+    volatile size_t  _pop_pos;
+    char             _pad2[ CACHE_LINE_SIZE ];
+
+    // prevent copy operations
+    TBoundedQueue ( const TBoundedQueue & );
+    TBoundedQueue & operator = ( const TBoundedQueue & );
+
+    //! @endcond
+
+public:
+    /////////////////////////////////////////////////
+    //
+    // constructor and destructor
+    //
+
+    //! construct queue for at least \a capacity elements
+    TBoundedQueue ( const size_t  capacity )
+            : _push_pos( 0 ), _pop_pos( 0 )
+    {
+        size_t  size = 2;
+
+        while ( size < capacity )
+            size *= 2;
+
+        _cells = new TCell[ size ];
+        _mask  = size - 1;
+
+        for ( size_t  i = 0; i < size; i++ )
+            _cells[i].seq = i;
+    }
+
+    //! dtor
+    ~TBoundedQueue () { delete[] _cells; }
+
+    /////////////////////////////////////////////////
+    //
+    // access queue
+    //
+
+    //! append \a val to queue; return false if queue is full
+    bool  push  ( const T &  val )
+    {
+        size_t   pos = atomic_load( _push_pos );
+        TCell *  cell;
+
+        while ( true )
+        {
+            cell = & _cells[ pos & _mask ];
+
+            const long  diff = long( atomic_load( cell->seq ) ) - long( pos );
+
+            if ( diff == 0 )
+            {
+                // cell is free: try to claim it
+                if ( atomic_cas( _push_pos, pos, pos+1 ) )
+                    break;
+
+                pos = atomic_load( _push_pos );
+            }// if
+            else if ( diff < 0 )
+                return false;
+            else
+                pos = atomic_load( _push_pos );
+        }// while
+
+        cell->data = val;
+        atomic_store( cell->seq, pos+1 );
+
+        return true;
+    }
+
+    //! remove first element from queue and store it in \a val;
+    //! return false if queue is empty
+    bool  pop   ( T &  val )
+    {
+        size_t   pos = atomic_load( _pop_pos );
+        TCell *  cell;
+
+        while ( true )
+        {
+            cell = & _cells[ pos & _mask ];
+
+            const long  diff = long( atomic_load( cell->seq ) ) - long( pos+1 );
+
+            if ( diff == 0 )
+            {
+                // cell is filled: try to claim it
+                if ( atomic_cas( _pop_pos, pos, pos+1 ) )
+                    break;
+
+                pos = atomic_load( _pop_pos );
+            }// if
+            else if ( diff < 0 )
+                return false;
+            else
+                pos = atomic_load( _pop_pos );
+        }// while
+
+        val = cell->data;
+        atomic_store( cell->seq, pos + _mask + 1 );
+
+        return true;
+    }
+
+    //! return true if queue is empty (elements being pushed count as queued)
+    bool  empty () const
+    {
+        return atomic_load( _push_pos ) == atomic_load( _pop_pos );
+    }
+
+    //! return capacity of queue
+    size_t  capacity () const { return _mask + 1; }
+};
+
+}// namespace ThreadPool
+
+#endif  // __TBOUNDEDQUEUE_HH
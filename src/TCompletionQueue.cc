@@ -0,0 +1,148 @@
+//
+//  Project : ThreadPool
+//  File    : TCompletionQueue.cc
+//  Author  : Ronald Kriemann
+//  Purpose : queue of finished jobs of a thread pool
+//
+
+#include "TCompletionQueue.hh"
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////
+//
+// constructor and destructor
+//
+
+TCompletionQueue::TCompletionQueue ()
+        : _stack( NULL ), _head( NULL )
+{}
+
+TCompletionQueue::~TCompletionQueue ()
+{}
+
+////////////////////////////////////////////
+//
+// append and remove jobs
+//
+
+//
+// append finished job
+//
+void
+TCompletionQueue::push ( TPool::TJob *  job )
+{
+    // job is still in queue (e.g. periodic job not yet removed)
+    if ( ! atomic_cas( job->_completion_queued, 0, 1 ) )
+        return;
+    
+    TPool::TJob *  top = atomic_load( _stack );
+
+    do
+    {
+        job->_completion_next = top;
+    } while ( ! __atomic_compare_exchange_n( & _stack, & top, job, true,
+                                             __ATOMIC_RELEASE, __ATOMIC_RELAXED ));
+
+    _event.notify_one();
+}
+
+//
+// remove next finished job
+//
+TPool::TJob *
+TCompletionQueue::poll ()
+{
+    if ( _head == NULL )
+        fetch();
+
+    TPool::TJob *  job = _head;
+
+    if ( job != NULL )
+    {
+        _head = job->_completion_next;
+        job->_completion_next = NULL;
+        atomic_store( job->_completion_queued, 0 );
+    }// if
+
+    return job;
+}
+
+//
+// remove next finished job, wait if none available
+//
+TPool::TJob *
+TCompletionQueue::wait_one ()
+{
+    while ( true )
+    {
+        TPool::TJob *  job = poll();
+
+        if ( job != NULL )
+            return job;
+
+        const int  key = _event.prepare_wait();
+
+        if ( atomic_load( _stack ) != NULL )
+            _event.cancel_wait();
+        else
+            _event.wait( key );
+    }// while
+}
+
+//
+// remove several finished jobs
+//
+size_t
+TCompletionQueue::drain ( TPool::TJob **  jobs,
+                          const size_t    max )
+{
+    size_t  n = 0;
+
+    while ( n < max )
+    {
+        TPool::TJob *  job = poll();
+
+        if ( job == NULL )
+            break;
+
+        jobs[n++] = job;
+    }// while
+
+    return n;
+}
+
+//
+// return true if no finished job is available
+//
+bool
+TCompletionQueue::empty () const
+{
+    return (( _head == NULL ) && ( atomic_load( _stack ) == NULL ));
+}
+
+//
+// move appended jobs to list of consumer
+//
+void
+TCompletionQueue::fetch ()
+{
+    TPool::TJob *  job = atomic_exchange( _stack, static_cast< TPool::TJob * >( NULL ) );
+
+    // stack holds most recent job first: reverse to order of completion
+    TPool::TJob *  list = NULL;
+
+    while ( job != NULL )
+    {
+        TPool::TJob *  next = job->_completion_next;
+
+        job->_completion_next = list;
+        list = job;
+        job  = next;
+    }// while
+
+    _head = list;
+}
+
+}// namespace ThreadPool
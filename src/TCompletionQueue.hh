@@ -0,0 +1,101 @@
+#ifndef __TCOMPLETIONQUEUE_HH
+#define __TCOMPLETIONQUEUE_HH
+//
+//  Project : ThreadPool
+//  File    : TCompletionQueue.hh
+//  Author  : Ronald Kriemann
+//  Purpose : queue of finished jobs of a thread pool
+//
+
+#include <cstddef>
+
+#include "TThreadPool.hh"
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TCompletionQueue
+//! \brief  receives jobs of a pool (or of a job group) in the order in
+//!         which they finish (see TPool::set_completion_queue and
+//!         TPool::TJobGroup::set_completion_queue):
+//!         - threads of pools append jobs without locking, a single
+//!           consumer removes them by "poll", "wait_one" or "drain"
+//!         - dropped jobs (e.g. cancelled) are reported as well, jobs
+//!           deleted by the pool are not reported
+//!         - a reported job may only be deleted or run again after it was
+//!           removed from the queue (sync is not sufficient); a job is
+//!           reported at most once until removed
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TCompletionQueue
+{
+protected:
+    //! @cond
+
+    // jobs appended by threads of pools (most recent first)
+    TPool::TJob * volatile  _stack;
+
+    // jobs taken from stack by consumer (in order of completion)
+    TPool::TJob *           _head;
+
+    // eventcount for consumer waiting for jobs
+    TEventCount             _event;
+
+    // prevent copy operations
+    TCompletionQueue ( const TCompletionQueue & );
+    TCompletionQueue & operator = ( const TCompletionQueue & );
+
+    //! @endcond
+
+public:
+    /////////////////////////////////////////////////
+    //
+    // constructor and destructor
+    //
+
+    //! construct empty completion queue
+    TCompletionQueue ();
+
+    //! dtor (remaining jobs are not deleted)
+    ~TCompletionQueue ();
+
+    /////////////////////////////////////////////////
+    //
+    // append and remove jobs
+    //
+
+    //! append finished \a job (called by threads of pools)
+    void           push      ( TPool::TJob *  job );
+
+    //! remove and return next finished job or NULL if none is available
+    TPool::TJob *  poll      ();
+
+    //! remove and return next finished job, wait until one is available
+    TPool::TJob *  wait_one  ();
+
+    //! remove up to \a max finished jobs and store them in \a jobs (in
+    //! order of completion); return number of removed jobs
+    size_t         drain     ( TPool::TJob **  jobs,
+                               const size_t    max );
+
+    //! return true if no finished job is available (only reliable for
+    //! the consumer)
+    bool           empty     () const;
+
+protected:
+    //! @cond
+
+    // move jobs appended by threads to list of consumer
+    void           fetch     ();
+
+    //! @endcond
+};
+
+}// namespace ThreadPool
+
+#endif  // __TCOMPLETIONQUEUE_HH
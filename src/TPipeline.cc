@@ -0,0 +1,345 @@
+//
+//  Project : ThreadPool
+//  File    : TPipeline.cc
+//  Author  : Ronald Kriemann
+//  Purpose : pipeline of stages executed by a thread pool
+//
+
+#include "TPipeline.hh"
+
+namespace ThreadPool
+{
+
+//
+// job passing a token to a stage
+//
+class TPipelineJob : public TPool::TJob
+{
+protected:
+    TPipeline *           _pipeline;
+    TPipeline::TToken *   _token;
+    const unsigned int    _stage;
+
+public:
+    TPipelineJob ( TPipeline *          pipeline,
+                   TPipeline::TToken *  token,
+                   const unsigned int   stage )
+            : _pipeline( pipeline ), _token( token ), _stage( stage )
+    {}
+
+    void run ( void * )
+    {
+        _pipeline->pass( _token, _stage );
+        _pipeline->release();
+    }
+};
+
+////////////////////////////////////////////
+//
+// constructor and destructor
+//
+
+TPipeline::TPipeline ()
+        : _pool( NULL ), _free( NULL ), _nfree( 0 ), _seq( 0 ),
+          _input_end( 0 ), _active( 0 ), _done( true )
+{}
+
+TPipeline::~TPipeline ()
+{}
+
+////////////////////////////////////////////
+//
+// pipeline management
+//
+
+//
+// append stage to pipeline
+//
+void
+TPipeline::add_stage ( TStage *  stage )
+{
+    if ( stage != NULL )
+        _stages.push_back( stage );
+}
+
+//
+// pass all items through pipeline
+//
+void
+TPipeline::run ( TPool &             pool,
+                 const unsigned int  max_tokens )
+{
+    const unsigned int  ntokens = ( max_tokens > 0 ? max_tokens : 1 );
+    const unsigned int  nstages = _stages.size();
+
+    if ( nstages == 0 )
+        return;
+
+    //
+    // set up tokens and queues of serial stages
+    //
+
+    _pool = & pool;
+    _tokens.resize( ntokens );
+    _free  = new TBoundedQueue< TToken * >( ntokens );
+    _nfree = ntokens;
+
+    for ( unsigned int  i = 0; i < ntokens; i++ )
+        _free->push( & _tokens[i] );
+
+    _data.resize( nstages );
+
+    for ( unsigned int  i = 0; i < nstages; i++ )
+    {
+        _data[i].busy  = 0;
+        _data[i].next  = 0;
+        _data[i].queue = NULL;
+        _data[i].ring.clear();
+
+        if ( i == 0 )
+            continue;
+
+        if ( _stages[i]->mode() == SERIAL_IN_ORDER )
+            _data[i].ring.resize( ntokens, NULL );
+        else if ( _stages[i]->mode() == SERIAL_OUT_OF_ORDER )
+            _data[i].queue = new TBoundedQueue< TToken * >( ntokens );
+    }// for
+
+    _seq       = 0;
+    _input_end = 0;
+    _active    = 1;
+    _done      = false;
+
+    //
+    // start producing items and wait for end of pipeline
+    //
+
+    produce();
+
+    {
+        TScopedLock  lock( _done_cond );
+
+        while ( ! _done )
+            _done_cond.wait();
+    }
+
+    for ( unsigned int  i = 0; i < nstages; i++ )
+    {
+        delete _data[i].queue;
+        _data[i].queue = NULL;
+    }// for
+
+    delete _free;
+    _free = NULL;
+}
+
+//
+// produce new tokens by first stage
+//
+void
+TPipeline::produce ()
+{
+    TStageData &  data = _data[0];
+
+    while ( true )
+    {
+        // only one thread executes the first stage
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if ( atomic_load( _input_end ) || ! atomic_cas( data.busy, 0, 1 ))
+            return;
+
+        while ( atomic_load( _nfree ) > 0 )
+        {
+            TToken *  token;
+
+            atomic_add( _nfree, -1 );
+
+            // token is available as counter is increased after push
+            while ( ! _free->pop( token ) )
+                cpu_relax();
+
+            void *  item = _stages[0]->process( NULL );
+
+            if ( item == NULL )
+            {
+                // end of input: drop reference of first stage
+                _free->push( token );
+                atomic_add( _nfree, 1 );
+                atomic_store( _input_end, 1 );
+                atomic_store( data.busy, 0 );
+                release();
+                return;
+            }// if
+
+            token->item = item;
+            token->seq  = _seq++;
+            atomic_add( _active, 1 );
+
+            forward( token, 1 );
+        }// while
+
+        atomic_store( data.busy, 0 );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        // recheck for tokens released after last check
+        if ( atomic_load( _nfree ) == 0 )
+            return;
+    }// while
+}
+
+//
+// pass token to stage
+//
+void
+TPipeline::pass ( TToken *            token,
+                  const unsigned int  stage )
+{
+    unsigned int  i = stage;
+
+    // execute parallel stages directly
+    while (( i < _stages.size() ) && ( _stages[i]->mode() == PARALLEL ))
+    {
+        token->item = _stages[i]->process( token->item );
+        i++;
+    }// while
+
+    if ( i == _stages.size() )
+        finish( token );
+    else
+        serial( token, i );
+}
+
+//
+// handle waiting tokens of serial stage
+//
+void
+TPipeline::serial ( TToken *            token,
+                    const unsigned int  stage )
+{
+    TStageData &  data     = _data[ stage ];
+    const bool    in_order = ( _stages[ stage ]->mode() == SERIAL_IN_ORDER );
+
+    // queue token (never full as queues hold all tokens)
+    if ( in_order )
+        atomic_store( data.ring[ token->seq % data.ring.size() ], token );
+    else
+    {
+        while ( ! data.queue->push( token ) )
+            cpu_relax();
+    }// else
+
+    while ( true )
+    {
+        // if another thread handles stage, it will also handle token
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if ( ! atomic_cas( data.busy, 0, 1 ) )
+            return;
+
+        TToken *  t;
+
+        while (( t = next_token( stage )) != NULL )
+        {
+            t->item = _stages[ stage ]->process( t->item );
+            forward( t, stage+1 );
+        }// while
+
+        const unsigned long  next = data.next;
+
+        atomic_store( data.busy, 0 );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        // recheck for tokens queued after last check
+        if ( in_order )
+        {
+            if ( atomic_load( data.ring[ next % data.ring.size() ] ) == NULL )
+                return;
+        }// if
+        else if ( data.queue->empty() )
+            return;
+    }// while
+}
+
+//
+// return next waiting token of serial stage
+//
+TPipeline::TToken *
+TPipeline::next_token ( const unsigned int  stage )
+{
+    TStageData &  data  = _data[ stage ];
+    TToken *      token = NULL;
+
+    if ( _stages[ stage ]->mode() == SERIAL_IN_ORDER )
+    {
+        const size_t  i = data.next % data.ring.size();
+
+        token = atomic_load( data.ring[i] );
+
+        if ( token != NULL )
+        {
+            data.ring[i] = NULL;
+            data.next++;
+        }// if
+    }// if
+    else if ( ! data.queue->pop( token ) )
+        token = NULL;
+
+    return token;
+}
+
+//
+// forward token to stage as new job
+//
+void
+TPipeline::forward ( TToken *            token,
+                     const unsigned int  stage )
+{
+    if ( stage >= _stages.size() )
+    {
+        finish( token );
+        return;
+    }// if
+
+    // running jobs count as active to keep pipeline data alive
+    atomic_add( _active, 1 );
+    
+    TPipelineJob *  job = new TPipelineJob( this, token, stage );
+    
+    if ( ! _pool->run( job, NULL, true ) )
+    {
+        // job was rejected by pool (and not deleted): execute directly
+        job->run( NULL );
+        delete job;
+    }// if
+}
+
+//
+// release token after last stage
+//
+void
+TPipeline::finish ( TToken *  token )
+{
+    _free->push( token );
+    atomic_add( _nfree, 1 );
+
+    produce();
+    release();
+}
+
+//
+// decrease number of active tokens
+//
+void
+TPipeline::release ()
+{
+    if ( atomic_add( _active, -1 ) == 0 )
+    {
+        TScopedLock  lock( _done_cond );
+
+        _done = true;
+        _done_cond.broadcast();
+    }// if
+}
+
+}// namespace ThreadPool
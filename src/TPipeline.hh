@@ -0,0 +1,195 @@
+#ifndef __TPIPELINE_HH
+#define __TPIPELINE_HH
+//
+//  Project : ThreadPool
+//  File    : TPipeline.hh
+//  Author  : Ronald Kriemann
+//  Purpose : pipeline of stages executed by a thread pool
+//
+
+#include <vector>
+
+#include "TThreadPool.hh"
+#include "TBoundedQueue.hh"
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TPipeline
+//! \brief  chain of stages, through which items are passed:
+//!         - the first stage produces items, all others transform them
+//!         - serial stages handle one item at a time, either in the order
+//!           produced by the first stage or in order of arrival,
+//!           parallel stages handle several items at once
+//!         - at most "max_tokens" items are in the pipeline at any time
+//!         - no thread of the pool blocks while waiting for a stage
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TPipeline
+{
+    friend class TPipelineJob;
+
+public:
+    //! execution modes of stages
+    enum mode_t
+    {
+        SERIAL_IN_ORDER,     //!< one item at a time in order of first stage
+        SERIAL_OUT_OF_ORDER, //!< one item at a time in order of arrival
+        PARALLEL             //!< several items at once
+    };
+
+    //!
+    //! \class  TStage
+    //! \brief  stage of pipeline
+    //!
+    class TStage
+    {
+        friend class TPipeline;
+
+    protected:
+        //! @cond
+
+        // execution mode
+        const mode_t  _mode;
+
+        //! @endcond
+
+    public:
+        //! construct stage with execution mode \a mode
+        TStage ( const mode_t  mode ) : _mode( mode ) {}
+
+        //! dtor
+        virtual ~TStage () {}
+
+        //! handle \a item and return item for next stage; the first stage
+        //! is called with NULL and returns NULL at end of input
+        virtual void *  process ( void *  item ) = 0;
+
+        //! return execution mode
+        mode_t  mode () const { return _mode; }
+    };
+
+protected:
+    //! @cond
+
+    // item passed through pipeline with sequence number of first stage
+    struct TToken
+    {
+        void *         item;
+        unsigned long  seq;
+    };
+
+    // state of a stage during "run"
+    struct TStageData
+    {
+        // indicates thread handling the stage
+        volatile int                      busy;
+
+        // tokens waiting for serial stage: ring indexed by sequence
+        // number for in-order stages, queue for out-of-order stages
+        std::vector< TToken * >           ring;
+        TBoundedQueue< TToken * > *       queue;
+
+        // next sequence number of in-order stage
+        unsigned long                     next;
+    };
+
+    // stages of pipeline
+    std::vector< TStage * >      _stages;
+
+    // pool executing stages
+    TPool *                      _pool;
+
+    // tokens and free tokens
+    std::vector< TToken >        _tokens;
+    TBoundedQueue< TToken * > *  _free;
+    volatile int                 _nfree;
+
+    // per stage data
+    std::vector< TStageData >    _data;
+
+    // next sequence number and indicates end of input
+    unsigned long                _seq;
+    volatile int                 _input_end;
+
+    // number of tokens in pipeline and of jobs of pipeline
+    // (plus one until end of input)
+    volatile int                 _active;
+
+    // signals end of pipeline
+    bool                         _done;
+    TCondition                   _done_cond;
+
+    // prevent copy operations
+    TPipeline ( const TPipeline & );
+    TPipeline & operator = ( const TPipeline & );
+
+    //! @endcond
+
+public:
+    /////////////////////////////////////////////////
+    //
+    // constructor and destructor
+    //
+
+    //! construct empty pipeline
+    TPipeline ();
+
+    //! dtor (stages are not deleted)
+    ~TPipeline ();
+
+    /////////////////////////////////////////////////
+    //
+    // pipeline management
+    //
+
+    //! append \a stage to pipeline (first stage is always serial)
+    void  add_stage ( TStage *  stage );
+
+    //! return number of stages
+    unsigned int  stages () const { return _stages.size(); }
+
+    //! pass all items of first stage through pipeline using threads of
+    //! \a pool with at most \a max_tokens items at once and wait until all
+    //! items have passed the last stage (not to be called by pool threads)
+    void  run       ( TPool &             pool,
+                      const unsigned int  max_tokens );
+
+protected:
+    //! @cond
+
+    // produce new tokens by first stage while free tokens are available
+    void  produce   ();
+
+    // pass token to stage (execute parallel stages directly)
+    void  pass      ( TToken *            token,
+                      const unsigned int  stage );
+
+    // handle waiting tokens of serial stage unless handled by other thread
+    void  serial    ( TToken *            token,
+                      const unsigned int  stage );
+
+    // return next waiting token of serial stage (or NULL)
+    TToken *  next_token ( const unsigned int  stage );
+
+    // forward token to stage as new job of pool
+    void  forward   ( TToken *            token,
+                      const unsigned int  stage );
+
+    // release token after last stage
+    void  finish    ( TToken *            token );
+
+    // decrease number of active tokens/jobs and signal end of pipeline
+    void  release   ();
+
+    //! @endcond
+};
+
+}// namespace ThreadPool
+
+#endif  // __TPIPELINE_HH
@@ -0,0 +1,243 @@
+//
+//  Project : ThreadPool
+//  File    : TStrand.cc
+//  Author  : Ronald Kriemann
+//  Purpose : serial execution of jobs by a thread pool
+//
+
+#include "TStrand.hh"
+
+namespace ThreadPool
+{
+
+//
+// job of pool handling queued jobs of a strand
+//
+class TStrandJob : public TPool::TJob
+{
+protected:
+    // strand to handle (NULL if handled by job or by caller)
+    TStrand *  _strand;
+
+public:
+    TStrandJob ( TStrand *  strand ) : _strand( strand ) {}
+
+    // job was dropped by pool without execution, e.g. during shutdown:
+    // release strand and its queued jobs
+    ~TStrandJob ()
+    {
+        if ( _strand != NULL )
+            _strand->drain( false );
+    }
+
+    void run ( void * )
+    {
+        TStrand *  strand = _strand;
+
+        // strand may be destructed after "drain"
+        _strand = NULL;
+        strand->drain();
+    }
+
+    // strand is handled by caller (job was rejected by pool)
+    void reject () { _strand = NULL; }
+};
+
+////////////////////////////////////////////
+//
+// constructor and destructor
+//
+
+TStrand::TStrand ( TPool &             pool,
+                   const unsigned int  batch )
+        : _pool( & pool ), _batch( batch > 0 ? batch : 1 ),
+          _queue_head( NULL ), _queue_tail( NULL ), _pending( 0 ),
+          _scheduled( false ), _sync_waiters( 0 )
+{}
+
+TStrand::~TStrand ()
+{
+    sync();
+}
+
+////////////////////////////////////////////
+//
+// run and synch with jobs
+//
+
+//
+// append job to strand
+//
+bool
+TStrand::post ( TPool::TJob *  job,
+                void *         ptr,
+                const bool     del )
+{
+    if ( job == NULL )
+        return false;
+
+    // lock job for synchronisation
+    job->lock();
+
+    job->_pool_next       = NULL;
+    job->_pool_arg        = ptr;
+    job->_pool_del        = del;
+    job->_pool_completion = _pool->completion_for( job );
+    atomic_store( job->_cancelled, 0 );
+
+    if ( job->_group != NULL )
+        job->_group->add_job();
+
+    bool  start = false;
+
+    {
+        TScopedLock  lock( _cond );
+
+        if ( _queue_tail == NULL )
+            _queue_head = job;
+        else
+            _queue_tail->_pool_next = job;
+
+        _queue_tail = job;
+        _pending++;
+
+        // only one job of the pool handles the strand
+        if ( ! _scheduled )
+        {
+            _scheduled = true;
+            start      = true;
+        }// if
+    }
+
+    // handle strand directly if rejected by pool
+    if ( start && ! schedule() )
+        drain();
+
+    return true;
+}
+
+//
+// wait for all jobs
+//
+void
+TStrand::sync ()
+{
+    TScopedLock  lock( _cond );
+
+    _sync_waiters++;
+
+    while ( _scheduled || ( _pending > 0 ))
+        _cond.wait();
+
+    _sync_waiters--;
+}
+
+//
+// return number of queued and running jobs
+//
+unsigned int
+TStrand::pending ()
+{
+    TScopedLock  lock( _cond );
+
+    return _pending;
+}
+
+//
+// execute queued jobs
+//
+void
+TStrand::drain ( const bool  execute )
+{
+    unsigned int  njobs   = 0;
+    bool          account = false;
+
+    while ( true )
+    {
+        TPool::TJob *  job = NULL;
+
+        {
+            TScopedLock  lock( _cond );
+
+            // account for previous job
+            if ( account )
+            {
+                _pending--;
+                account = false;
+            }// if
+            
+            if ( _queue_head == NULL )
+            {
+                // strand is empty: next "post" schedules it again
+                _scheduled = false;
+
+                if ( _sync_waiters > 0 )
+                    _cond.broadcast();
+
+                return;
+            }// if
+
+            if ( ! execute || ( njobs < _batch ))
+            {
+                job         = _queue_head;
+                _queue_head = job->_pool_next;
+
+                if ( _queue_head == NULL )
+                    _queue_tail = NULL;
+            }// if
+        }
+
+        if ( job == NULL )
+        {
+            // batch is done: requeue strand in pool to let other jobs run
+            // first (or continue if rejected by pool, but never execute
+            // strand recursively in this thread)
+            if ( schedule( false ) )
+                return;
+
+            njobs = 0;
+            continue;
+        }// if
+        
+        TPool::TJobGroup *  group = job->_group;
+        const bool          del   = job->_pool_del;
+
+        // drop cancelled jobs without execution
+        if ( execute && ! job->is_cancelled() )
+            job->run( job->_pool_arg );
+
+        // common release of pool jobs (incl. completion queue)
+        TPool::finish( job, del );
+
+        if ( group != NULL )
+            group->finish_job();
+
+        njobs++;
+        account = true;
+    }// while
+}
+
+//
+// give strand to pool
+//
+bool
+TStrand::schedule ( const bool  may_inline )
+{
+    // sequential pool executes jobs in calling thread
+    if ( ! may_inline && _pool->sequential() )
+        return false;
+    
+    TStrandJob *  job = new TStrandJob( this );
+
+    // with "try_run", the pool never executes the job in this thread
+    if ( may_inline ? _pool->run( job, NULL, true ) : _pool->try_run( job, NULL, true ) )
+        return true;
+
+    // rejected job is not deleted by pool
+    job->reject();
+    delete job;
+
+    return false;
+}
+
+}// namespace ThreadPool
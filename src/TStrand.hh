@@ -0,0 +1,120 @@
+#ifndef __TSTRAND_HH
+#define __TSTRAND_HH
+//
+//  Project : ThreadPool
+//  File    : TStrand.hh
+//  Author  : Ronald Kriemann
+//  Purpose : serial execution of jobs by a thread pool
+//
+
+#include "TThreadPool.hh"
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TStrand
+//! \brief  executes jobs one after another in the order of "post"
+//!         using threads of a pool:
+//!         - jobs of a strand never run concurrently, so data only
+//!           accessed by these jobs needs no further locking
+//!         - an empty strand occupies no thread of the pool and no
+//!           thread waits for its turn; jobs are queued in the strand
+//!           and executed by a single job of the pool
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TStrand
+{
+    friend class TStrandJob;
+
+protected:
+    //! @cond
+
+    // pool executing jobs
+    TPool *        _pool;
+
+    // maximal number of jobs executed before the strand is requeued
+    // in the pool (allows other jobs to run in between)
+    unsigned int   _batch;
+
+    // condition guarding queue and signalling empty strand
+    TCondition     _cond;
+
+    // queue of jobs (FIFO)
+    TPool::TJob *  _queue_head;
+    TPool::TJob *  _queue_tail;
+
+    // number of queued and running jobs
+    unsigned int   _pending;
+
+    // indicates a job of the pool handling the strand
+    bool           _scheduled;
+
+    // number of threads waiting in "sync"
+    unsigned int   _sync_waiters;
+
+    // prevent copy operations
+    TStrand ( const TStrand & );
+    TStrand & operator = ( const TStrand & );
+
+    //! @endcond
+
+public:
+    /////////////////////////////////////////////////
+    //
+    // constructor and destructor
+    //
+
+    //! construct strand executing jobs with threads of \a pool; after
+    //! \a batch jobs, the strand is requeued in the pool
+    TStrand ( TPool &             pool,
+              const unsigned int  batch = 16 );
+
+    //! wait for all jobs and destruct strand
+    ~TStrand ();
+
+    /////////////////////////////////////////////////
+    //
+    // run and synch with jobs
+    //
+
+    //! append \a job to strand, e.g. execute \a job after all jobs posted
+    //! before; \a ptr and \a del are as for TPool::run; if the pool rejects
+    //! to handle the strand, the queued jobs are executed by the calling
+    //! thread; return false only if \a job is NULL
+    bool          post    ( TPool::TJob *  job,
+                            void *         ptr = NULL,
+                            const bool     del = false );
+
+    //! wait until all posted jobs have finished (not to be called by
+    //! jobs of the strand)
+    void          sync    ();
+
+    //! return number of queued and running jobs
+    unsigned int  pending ();
+
+    //! return pool of strand
+    TPool &       pool    () { return * _pool; }
+
+protected:
+    //! @cond
+
+    // execute queued jobs until strand is empty or batch is done; if
+    // not "execute", queued jobs are dropped without execution
+    void  drain    ( const bool  execute = true );
+
+    // give strand to pool for execution; return false if rejected; if not
+    // "may_inline", the strand is not executed by the calling thread (e.g.
+    // with SATURATION_CALLER_RUNS or a sequential pool)
+    bool  schedule ( const bool  may_inline = true );
+
+    //! @endcond
+};
+
+}// namespace ThreadPool
+
+#endif  // __TSTRAND_HH
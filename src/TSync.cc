@@ -0,0 +1,312 @@
+//
+//  Project : ThreadPool
+//  File    : TSync.cc
+//  Author  : Ronald Kriemann
+//  Purpose : synchronisation primitives with uncontended paths in userspace
+//
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "TSync.hh"
+
+namespace ThreadPool
+{
+
+#if defined(__linux__)
+
+////////////////////////////////////////////
+//
+// futex based waiting
+//
+
+void
+futex_wait ( volatile int *  addr,
+             const int       val )
+{
+    syscall( SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0 );
+}
+
+void
+futex_wake ( volatile int *  addr,
+             const int       n )
+{
+    syscall( SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0 );
+}
+
+#else
+
+////////////////////////////////////////////
+//
+// emulation of futex by hashed condition variables
+//
+
+namespace
+{
+
+const unsigned int  N_BUCKETS = 64;
+
+TCondition  buckets[ N_BUCKETS ];
+
+TCondition &
+bucket ( volatile int *  addr )
+{
+    return buckets[ (reinterpret_cast< unsigned long >( addr ) / sizeof(int)) % N_BUCKETS ];
+}
+
+}// namespace anonymous
+
+void
+futex_wait ( volatile int *  addr,
+             const int       val )
+{
+    TCondition &  cond = bucket( addr );
+    TScopedLock   lock( cond );
+
+    if ( atomic_load( *addr ) == val )
+        cond.wait();
+}
+
+void
+futex_wake ( volatile int *  addr,
+             const int       )
+{
+    TCondition &  cond = bucket( addr );
+    TScopedLock   lock( cond );
+
+    cond.broadcast();
+}
+
+#endif
+
+namespace
+{
+
+// number of spin rounds before blocking and maximal backoff (in pauses)
+const unsigned int  SPIN_ROUNDS = 10;
+const unsigned int  MAX_BACKOFF = 64;
+
+// return number of spin rounds (no spinning on a single processor, as
+// the thread holding the lock can not run meanwhile)
+inline unsigned int
+spin_rounds ()
+{
+    static const unsigned int  rounds = ( available_cpus() > 1 ? SPIN_ROUNDS : 0 );
+
+    return rounds;
+}
+
+// spin for n pauses and double n
+inline void
+backoff ( unsigned int &  n )
+{
+    for ( unsigned int  i = 0; i < n; i++ )
+        cpu_relax();
+
+    if ( n < MAX_BACKOFF )
+        n *= 2;
+}
+
+// block while *addr equals val, counting blocked thread in sleepers
+inline void
+sleep_on ( volatile int *  addr,
+           const int       val,
+           volatile int &  sleepers )
+{
+    __atomic_add_fetch( & sleepers, 1, __ATOMIC_SEQ_CST );
+    futex_wait( addr, val );
+    atomic_add( sleepers, -1 );
+}
+
+}// namespace anonymous
+
+////////////////////////////////////////////
+//
+// TSpinLock
+//
+
+void
+TSpinLock::lock_slow ()
+{
+    unsigned int  n = 1;
+
+    for ( unsigned int  r = 0; r < spin_rounds(); r++ )
+    {
+        backoff( n );
+
+        if (( atomic_load( _state ) == 0 ) && atomic_cas( _state, 0, 1 ))
+            return;
+    }// for
+
+    // mark lock as contended and block
+    while ( atomic_exchange( _state, 2 ) != 0 )
+        futex_wait( & _state, 2 );
+}
+
+////////////////////////////////////////////
+//
+// TRWLock
+//
+
+void
+TRWLock::lock_shared_slow ()
+{
+    unsigned int  n = 1;
+    unsigned int  r = 0;
+
+    while ( true )
+    {
+        const int  s = atomic_load( _state );
+
+        if (( s & ( WRITER | WAIT_MASK )) == 0 )
+        {
+            if ( atomic_cas( _state, s, s + READER_ONE ) )
+                return;
+
+            continue;
+        }// if
+
+        if ( r < spin_rounds() )
+        {
+            backoff( n );
+            r++;
+        }// if
+        else
+            sleep( s );
+    }// while
+}
+
+void
+TRWLock::lock_slow ()
+{
+    unsigned int  n = 1;
+
+    for ( unsigned int  r = 0; r < spin_rounds(); r++ )
+    {
+        backoff( n );
+
+        const int  s = atomic_load( _state );
+
+        if ((( s & ( WRITER | READER_MASK )) == 0 ) && atomic_cas( _state, s, s | WRITER ))
+            return;
+    }// for
+
+    // block new readers while waiting
+    atomic_add( _state, int(WAIT_ONE) );
+
+    while ( true )
+    {
+        const int  s = atomic_load( _state );
+
+        if (( s & ( WRITER | READER_MASK )) == 0 )
+        {
+            if ( atomic_cas( _state, s, s - WAIT_ONE + WRITER ) )
+                return;
+
+            continue;
+        }// if
+
+        sleep( s );
+    }// while
+}
+
+void
+TRWLock::sleep ( const int  s )
+{
+    sleep_on( & _state, s, _sleepers );
+}
+
+////////////////////////////////////////////
+//
+// TSemaphore
+//
+
+void
+TSemaphore::acquire_slow ()
+{
+    unsigned int  n = 1;
+
+    for ( unsigned int  r = 0; r < spin_rounds(); r++ )
+    {
+        backoff( n );
+
+        if ( try_acquire() )
+            return;
+    }// for
+
+    while ( ! try_acquire() )
+        sleep_on( & _count, 0, _sleepers );
+}
+
+////////////////////////////////////////////
+//
+// TBarrier
+//
+
+bool
+TBarrier::arrive_and_wait ()
+{
+    const int  phase = atomic_load( _phase );
+
+    if ( atomic_add( _count, 1 ) == _nthreads )
+    {
+        // last thread: start next phase
+        atomic_store( _count, 0 );
+        atomic_add( _phase, 1 );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if ( atomic_load( _sleepers ) > 0 )
+            futex_wake( & _phase, 0x7fffffff );
+
+        return true;
+    }// if
+
+    unsigned int  n = 1;
+
+    for ( unsigned int  r = 0; r < spin_rounds(); r++ )
+    {
+        if ( atomic_load( _phase ) != phase )
+            return false;
+
+        backoff( n );
+    }// for
+
+    while ( atomic_load( _phase ) == phase )
+        sleep_on( & _phase, phase, _sleepers );
+
+    return false;
+}
+
+////////////////////////////////////////////
+//
+// TLatch
+//
+
+void
+TLatch::wait_slow ()
+{
+    unsigned int  n = 1;
+
+    for ( unsigned int  r = 0; r < spin_rounds(); r++ )
+    {
+        backoff( n );
+
+        if ( try_wait() )
+            return;
+    }// for
+
+    while ( true )
+    {
+        const int  c = atomic_load( _count );
+
+        if ( c <= 0 )
+            return;
+
+        sleep_on( & _count, c, _sleepers );
+    }// while
+}
+
+}// namespace ThreadPool
@@ -0,0 +1,479 @@
+#ifndef __TSYNC_HH
+#define __TSYNC_HH
+//
+//  Project : ThreadPool
+//  File    : TSync.hh
+//  Author  : Ronald Kriemann
+//  Purpose : synchronisation primitives with uncontended paths in userspace
+//
+
+#include "TThread.hh"
+#include "TAtomic.hh"
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////////////////////
+//
+// low level waiting on an integer (futex on Linux)
+//
+////////////////////////////////////////////////////////////
+
+//! block calling thread while \a addr holds \a val (may return spuriously)
+void  futex_wait ( volatile int *  addr,
+                   const int       val );
+
+//! wake up to \a n threads blocked in futex_wait on \a addr
+void  futex_wake ( volatile int *  addr,
+                   const int       n );
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TEventCount
+//! \brief  eventcount, e.g. a condition variable without mutex:
+//!         - waiting thread calls prepare_wait, rechecks its predicate and
+//!           calls either cancel_wait or wait
+//!         - notifying thread changes predicate and calls notify_*, which
+//!           performs no system call if no thread is waiting
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TEventCount
+{
+protected:
+    //! @cond
+
+    // epoch, incremented by each notification (futex word)
+    volatile int  _epoch;
+
+    // number of threads in prepare_wait/wait
+    volatile int  _waiters;
+
+    //! @endcond
+
+public:
+    /////////////////////////////////////////////////
+    //
+    // constructor
+    //
+
+    TEventCount () : _epoch(0), _waiters(0) {}
+
+    /////////////////////////////////////////////////
+    //
+    // waiting
+    //
+
+    //! announce intention to wait; return key for "wait"
+    int   prepare_wait ()
+    {
+        __atomic_add_fetch( & _waiters, 1, __ATOMIC_SEQ_CST );
+
+        return atomic_load( _epoch );
+    }
+
+    //! withdraw announcement (predicate became true)
+    void  cancel_wait  ()
+    {
+        atomic_add( _waiters, -1 );
+    }
+
+    //! block until notification after prepare_wait returned \a key
+    void  wait         ( const int  key )
+    {
+        while ( atomic_load( _epoch ) == key )
+            futex_wait( & _epoch, key );
+
+        atomic_add( _waiters, -1 );
+    }
+
+    /////////////////////////////////////////////////
+    //
+    // notification
+    //
+
+    //! wake one waiting thread
+    void  notify_one   ()
+    {
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if ( atomic_load( _waiters ) == 0 )
+            return;
+
+        atomic_add( _epoch, 1 );
+        futex_wake( & _epoch, 1 );
+    }
+
+    //! wake all waiting threads
+    void  notify_all   ()
+    {
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if ( atomic_load( _waiters ) == 0 )
+            return;
+
+        atomic_add( _epoch, 1 );
+        futex_wake( & _epoch, 0x7fffffff );
+    }
+
+    //! return number of waiting threads
+    int   waiters      () const { return atomic_load( _waiters ); }
+};
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TSpinLock
+//! \brief  mutual exclusion for short critical sections: contending
+//!         threads spin with exponential backoff and only block in the
+//!         kernel if the lock is held for a longer time
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TSpinLock
+{
+protected:
+    //! @cond
+
+    // 0: unlocked, 1: locked, 2: locked with blocked threads (futex word)
+    volatile int  _state;
+
+    // prevent copy operations
+    TSpinLock ( const TSpinLock & );
+    TSpinLock & operator = ( const TSpinLock & );
+
+    //! @endcond
+
+public:
+    //! construct unlocked lock
+    TSpinLock () : _state(0) {}
+
+    //! lock
+    void  lock      ()
+    {
+        if ( ! atomic_cas( _state, 0, 1 ) )
+            lock_slow();
+    }
+
+    //! unlock
+    void  unlock    ()
+    {
+        if ( atomic_exchange( _state, 0 ) == 2 )
+            futex_wake( & _state, 1 );
+    }
+
+    //! try to lock and return true on success
+    bool  try_lock  () { return atomic_cas( _state, 0, 1 ); }
+
+    //! return true if locked (without modifying the lock)
+    bool  is_locked () const { return atomic_load( _state ) != 0; }
+
+protected:
+    //! @cond
+
+    // spin and block until locked
+    void  lock_slow ();
+
+    //! @endcond
+};
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TRWLock
+//! \brief  reader-writer lock for read-mostly data:
+//!         - readers acquire the lock by a single atomic operation if
+//!           no writer holds or waits for the lock
+//!         - waiting writers block new readers, i.e. writers can not
+//!           starve
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TRWLock
+{
+protected:
+    //! @cond
+
+    // layout of state: readers, waiting writers and writer flag
+    enum { READER_ONE  = 0x00000001,
+           READER_MASK = 0x000fffff,
+           WAIT_ONE    = 0x00100000,
+           WAIT_MASK   = 0x3ff00000,
+           WRITER      = 0x40000000 };
+
+    // state of lock (futex word)
+    volatile int  _state;
+
+    // number of threads blocked in kernel
+    volatile int  _sleepers;
+
+    // prevent copy operations
+    TRWLock ( const TRWLock & );
+    TRWLock & operator = ( const TRWLock & );
+
+    //! @endcond
+
+public:
+    //! construct unlocked lock
+    TRWLock () : _state(0), _sleepers(0) {}
+
+    //! lock for reading (shared with other readers)
+    void  lock_shared     ()
+    {
+        const int  s = atomic_load( _state );
+
+        if ((( s & ( WRITER | WAIT_MASK )) != 0 ) || ! atomic_cas( _state, s, s + READER_ONE ))
+            lock_shared_slow();
+    }
+
+    //! unlock after reading
+    void  unlock_shared   ()
+    {
+        const int  s = atomic_add( _state, int(-READER_ONE) );
+
+        // last reader wakes waiting writers
+        if ((( s & READER_MASK ) == 0 ) && (( s & WAIT_MASK ) != 0 ))
+            wake();
+    }
+
+    //! try to lock for reading and return true on success
+    bool  try_lock_shared ()
+    {
+        const int  s = atomic_load( _state );
+
+        return ((( s & ( WRITER | WAIT_MASK )) == 0 ) && atomic_cas( _state, s, s + READER_ONE ));
+    }
+
+    //! lock for writing (exclusive)
+    void  lock            ()
+    {
+        if ( ! atomic_cas( _state, 0, int(WRITER) ) )
+            lock_slow();
+    }
+
+    //! unlock after writing
+    void  unlock          ()
+    {
+        atomic_add( _state, int(-WRITER) );
+        wake();
+    }
+
+    //! try to lock for writing and return true on success
+    bool  try_lock        () { return atomic_cas( _state, 0, int(WRITER) ); }
+
+protected:
+    //! @cond
+
+    // spin and block until locked
+    void  lock_shared_slow ();
+    void  lock_slow        ();
+
+    // block while state equals s
+    void  sleep            ( const int  s );
+
+    // wake all blocked threads (if any)
+    void  wake             ()
+    {
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if ( atomic_load( _sleepers ) > 0 )
+            futex_wake( & _state, 0x7fffffff );
+    }
+
+    //! @endcond
+};
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TSemaphore
+//! \brief  counting semaphore
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TSemaphore
+{
+protected:
+    //! @cond
+
+    // number of available units (futex word)
+    volatile int  _count;
+
+    // number of threads blocked in kernel
+    volatile int  _sleepers;
+
+    // prevent copy operations
+    TSemaphore ( const TSemaphore & );
+    TSemaphore & operator = ( const TSemaphore & );
+
+    //! @endcond
+
+public:
+    //! construct semaphore with \a n units
+    TSemaphore ( const int  n = 0 ) : _count(n), _sleepers(0) {}
+
+    //! take one unit, wait if none is available
+    void  acquire     ()
+    {
+        if ( ! try_acquire() )
+            acquire_slow();
+    }
+
+    //! take one unit if available and return true on success
+    bool  try_acquire ()
+    {
+        int  c = atomic_load( _count );
+
+        while ( c > 0 )
+        {
+            if ( atomic_cas( _count, c, c-1 ) )
+                return true;
+
+            c = atomic_load( _count );
+        }// while
+
+        return false;
+    }
+
+    //! return \a n units
+    void  release     ( const int  n = 1 )
+    {
+        atomic_add( _count, n );
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if ( atomic_load( _sleepers ) > 0 )
+            futex_wake( & _count, n );
+    }
+
+    //! return number of available units
+    int   value       () const { return atomic_load( _count ); }
+
+protected:
+    //! @cond
+
+    // spin and block until unit is available
+    void  acquire_slow ();
+
+    //! @endcond
+};
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TBarrier
+//! \brief  reusable barrier for a fixed number of threads
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TBarrier
+{
+protected:
+    //! @cond
+
+    // number of threads
+    const int     _nthreads;
+
+    // number of threads arrived in current phase
+    volatile int  _count;
+
+    // number of phase (futex word)
+    volatile int  _phase;
+
+    // number of threads blocked in kernel
+    volatile int  _sleepers;
+
+    // prevent copy operations
+    TBarrier ( const TBarrier & );
+    TBarrier & operator = ( const TBarrier & );
+
+    //! @endcond
+
+public:
+    //! construct barrier for \a n threads
+    TBarrier ( const int  n ) : _nthreads( n > 0 ? n : 1 ), _count(0), _phase(0), _sleepers(0) {}
+
+    //! wait until all threads have arrived; return true for exactly one
+    //! thread per phase (the last one arriving)
+    bool  arrive_and_wait ();
+
+    //! return number of threads
+    int   size            () const { return _nthreads; }
+};
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TLatch
+//! \brief  single-use counter, threads wait until it drops to zero
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TLatch
+{
+protected:
+    //! @cond
+
+    // remaining count (futex word)
+    volatile int  _count;
+
+    // number of threads blocked in kernel
+    volatile int  _sleepers;
+
+    // prevent copy operations
+    TLatch ( const TLatch & );
+    TLatch & operator = ( const TLatch & );
+
+    //! @endcond
+
+public:
+    //! construct latch with count \a n
+    TLatch ( const int  n ) : _count( n > 0 ? n : 0 ), _sleepers(0) {}
+
+    //! decrease count by \a n and wake waiting threads if zero
+    void  count_down      ( const int  n = 1 )
+    {
+        if ( atomic_add( _count, -n ) <= 0 )
+        {
+            __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+            if ( atomic_load( _sleepers ) > 0 )
+                futex_wake( & _count, 0x7fffffff );
+        }// if
+    }
+
+    //! return true if count has reached zero
+    bool  try_wait        () const { return atomic_load( _count ) <= 0; }
+
+    //! wait until count has reached zero
+    void  wait            ()
+    {
+        if ( ! try_wait() )
+            wait_slow();
+    }
+
+    //! decrease count by \a n and wait until zero
+    void  arrive_and_wait ( const int  n = 1 )
+    {
+        count_down( n );
+        wait();
+    }
+
+protected:
+    //! @cond
+
+    // spin and block until count is zero
+    void  wait_slow ();
+
+    //! @endcond
+};
+
+}// namespace ThreadPool
+
+#endif  // __TSYNC_HH
@@ -9,9 +9,19 @@
 #include <signal.h>
 #include <time.h>
 #include <sched.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 
 #include <iostream>
+#include <fstream>
+#include <string>
 #include <cmath>
 
 #include "TThread.hh"
@@ -19,6 +29,181 @@
 namespace ThreadPool
 {
 
+//
+// return time of monotonic clock in seconds
+//
+double
+monotonic_time ()
+{
+    struct timespec  ts;
+
+    clock_gettime( CLOCK_MONOTONIC, & ts );
+
+    return double( ts.tv_sec ) + double( ts.tv_nsec ) * 1e-9;
+}
+
+namespace
+{
+
+#if defined(__linux__)
+
+//
+// return number of processors of CPU quota in cgroup directory <dir> and
+// all parent directories up to <root> (0: no quota)
+//
+unsigned int
+cgroup_quota ( const std::string &  root,
+               std::string          dir,
+               const bool           v2 )
+{
+    unsigned int  cpus = 0;
+
+    while ( true )
+    {
+        const std::string  path = root + dir;
+        long               quota  = -1;
+        long               period = 0;
+
+        if ( v2 )
+        {
+            // format: "<quota> <period>" with quota "max" for unlimited
+            std::ifstream  in( ( path + "/cpu.max" ).c_str() );
+            std::string    max;
+            
+            if ( in >> max >> period && ( max != "max" ))
+                quota = atol( max.c_str() );
+        }// if
+        else
+        {
+            std::ifstream  in_quota(  ( path + "/cpu.cfs_quota_us"  ).c_str() );
+            std::ifstream  in_period( ( path + "/cpu.cfs_period_us" ).c_str() );
+
+            if ( ! ( in_quota >> quota && in_period >> period ))
+                quota = -1;
+        }// else
+
+        if (( quota > 0 ) && ( period > 0 ))
+        {
+            // round up partial processors
+            const unsigned int  n = ( quota + period - 1 ) / period;
+
+            if (( cpus == 0 ) || ( n < cpus ))
+                cpus = n;
+        }// if
+
+        if ( dir.empty() || ( dir == "/" ))
+            break;
+
+        // continue with parent cgroup
+        const std::string::size_type  pos = dir.rfind( '/' );
+
+        dir = ( pos == std::string::npos ? std::string( "" ) : dir.substr( 0, pos ) );
+    }// while
+
+    return cpus;
+}
+
+//
+// return number of processors of CPU quota of process (0: no quota)
+//
+unsigned int
+cpu_quota ()
+{
+    std::ifstream  in( "/proc/self/cgroup" );
+    std::string    line;
+    unsigned int   cpus = 0;
+
+    // lines have format "<id>:<controllers>:<path>"
+    while ( std::getline( in, line ))
+    {
+        const std::string::size_type  first  = line.find( ':' );
+        const std::string::size_type  second = line.find( ':', first+1 );
+
+        if (( first == std::string::npos ) || ( second == std::string::npos ))
+            continue;
+
+        const std::string  ctrl = "," + line.substr( first+1, second-first-1 ) + ",";
+        const std::string  dir  = line.substr( second+1 );
+        unsigned int       n    = 0;
+
+        if ( line.substr( 0, first ) == "0" && ( ctrl == ",," ))
+            n = cgroup_quota( "/sys/fs/cgroup", dir, true );
+        else if ( ctrl.find( ",cpu," ) != std::string::npos )
+        {
+            n = cgroup_quota( "/sys/fs/cgroup/cpu", dir, false );
+
+            if ( n == 0 )
+                n = cgroup_quota( "/sys/fs/cgroup/cpu,cpuacct", dir, false );
+        }// if
+
+        if (( n > 0 ) && (( cpus == 0 ) || ( n < cpus )))
+            cpus = n;
+    }// while
+
+    return cpus;
+}
+
+#endif
+
+//
+// convert monotonic time <t> into absolute time for the monotonic
+// or the realtime clock
+//
+void
+to_timespec ( const double       t,
+              const bool         realtime,
+              struct timespec &  abs_time )
+{
+    double  deadline = t;
+
+    if ( realtime )
+    {
+        struct timespec  real_now;
+
+        clock_gettime( CLOCK_REALTIME, & real_now );
+        deadline += double( real_now.tv_sec ) + double( real_now.tv_nsec ) * 1e-9 - monotonic_time();
+    }// if
+
+    if ( deadline < 0.0 )
+        deadline = 0.0;
+
+    abs_time.tv_sec  = time_t( std::floor( deadline ) );
+    abs_time.tv_nsec = long( (deadline - double( abs_time.tv_sec )) * 1e9 );
+
+    if ( abs_time.tv_nsec >= 1000000000L )
+    {
+        abs_time.tv_sec  += 1;
+        abs_time.tv_nsec -= 1000000000L;
+    }// if
+}
+
+}// namespace anonymous
+
+//
+// return number of processors available to the process
+//
+unsigned int
+available_cpus ()
+{
+    long  cpus = sysconf( _SC_NPROCESSORS_ONLN );
+
+#if defined(__linux__)
+    cpu_set_t  cpu_set;
+
+    CPU_ZERO( & cpu_set );
+    
+    if ( sched_getaffinity( 0, sizeof(cpu_set), & cpu_set ) == 0 )
+        cpus = CPU_COUNT( & cpu_set );
+
+    const unsigned int  quota = cpu_quota();
+
+    if (( quota > 0 ) && ( long(quota) < cpus ))
+        cpus = quota;
+#endif
+
+    return ( cpus > 0 ? static_cast< unsigned int >( cpus ) : 1 );
+}
+
 //
 // routine to call TThread::run() method
 //
@@ -28,6 +213,7 @@ _run_thread ( void *arg )
 {
     if (arg != NULL)
     {
+        ((TThread*) arg)->apply_attr();
         ((TThread*) arg)->run();
         ((TThread*) arg)->reset_running();
     }// if
@@ -41,7 +227,7 @@ _run_thread ( void *arg )
 //
     
 TThread::TThread ( const int athread_no )
-        : _running( false ), _thread_no(athread_no)
+        : _running( false ), _joinable( false ), _thread_no(athread_no)
 {
 }
 
@@ -50,6 +236,10 @@ TThread::~TThread ()
     // request cancellation of the thread if running
     if ( _running )
         cancel();
+
+    // release resources of finished but not joined thread
+    if ( _joinable )
+        detach();
 }
 
 ////////////////////////////////////////////
@@ -75,6 +265,10 @@ void
 TThread::create ( const bool  detached,
                   const bool  sscope )
 {
+    // reap previous, finished but not yet joined thread
+    if ( ! _running && _joinable )
+        join();
+    
     if ( ! _running )
     {
         int             status;
@@ -110,39 +304,104 @@ TThread::create ( const bool  detached,
             }// if
         }// if
             
+        if ( _attr.stack_size > 0 )
+        {
+            size_t  size = _attr.stack_size;
+
+            if ( size < size_t( PTHREAD_STACK_MIN ) )
+                size = size_t( PTHREAD_STACK_MIN );
+            
+            if ((status = pthread_attr_setstacksize( & thread_attr, size )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setstacksize ("
+                          << strerror( status ) << ")" << std::endl;
+        }// if
+#ifdef HPUX
+        else
+        {
+            // on HP-UX we increase the stack-size for a stable behaviour
+            // (need much memory for this !!!)
+            pthread_attr_setstacksize( & thread_attr, 32 * 1024 * 1024 );
+        }// else
+#endif
+
+        if ( _attr.guard_size > 0 )
+        {
+            if ((status = pthread_attr_setguardsize( & thread_attr, _attr.guard_size )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setguardsize ("
+                          << strerror( status ) << ")" << std::endl;
+        }// if
+
+        const bool  explicit_sched = ( _attr.sched_policy >= 0 );
+        
+        if ( explicit_sched )
+        {
+            //
+            // use given scheduling policy and priority
+            //
+            
+            struct sched_param  t_param;
+
+            memset( & t_param, 0, sizeof(t_param) );
+            t_param.sched_priority = _attr.sched_priority;
+            
+            if ((status = pthread_attr_setinheritsched( & thread_attr, PTHREAD_EXPLICIT_SCHED )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setinheritsched ("
+                          << strerror( status ) << ")" << std::endl;
+            
+            if ((status = pthread_attr_setschedpolicy(  & thread_attr, _attr.sched_policy )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setschedpolicy ("
+                          << strerror( status ) << ")" << std::endl;
+        
+            if ((status = pthread_attr_setschedparam(   & thread_attr, & t_param )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setschedparam ("
+                          << strerror( status ) << ")" << std::endl;
+        }// if
+        
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && defined(SUNOS)
-        //
-        // adjust thread-scheduling for Solaris
-        //
+        else
+        {
+            //
+            // adjust thread-scheduling for Solaris
+            //
         
-        struct sched_param  t_param;
+            struct sched_param  t_param;
         
-        t_param.sched_priority = sched_get_priority_min( SCHED_RR );
+            t_param.sched_priority = sched_get_priority_min( SCHED_RR );
         
-        if ((status = pthread_attr_setschedpolicy(  & thread_attr, SCHED_RR )) != 0)
-            std::cerr << "(TThread) create : pthread_attr_setschedpolicy ("
-                      << strerror( status ) << ")" << std::endl;
+            if ((status = pthread_attr_setschedpolicy(  & thread_attr, SCHED_RR )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setschedpolicy ("
+                          << strerror( status ) << ")" << std::endl;
         
-        if ((status = pthread_attr_setschedparam(   & thread_attr, & t_param )) != 0)
-            std::cerr << "(TThread) create : pthread_attr_setschedparam ("
-                      << strerror( status ) << ")" << std::endl;
+            if ((status = pthread_attr_setschedparam(   & thread_attr, & t_param )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setschedparam ("
+                          << strerror( status ) << ")" << std::endl;
 
-        if ((status = pthread_attr_setinheritsched( & thread_attr, PTHREAD_EXPLICIT_SCHED )) != 0)
-            std::cerr << "(TThread) create : pthread_attr_setinheritsched ("
-                      << strerror( status ) << ")" << std::endl;
+            if ((status = pthread_attr_setinheritsched( & thread_attr, PTHREAD_EXPLICIT_SCHED )) != 0)
+                std::cerr << "(TThread) create : pthread_attr_setinheritsched ("
+                          << strerror( status ) << ")" << std::endl;
+        }// else
 #endif
+        
+        status = pthread_create( & _thread_id, & thread_attr, _run_thread, this );
 
-#ifdef HPUX
-        // on HP-UX we increase the stack-size for a stable behaviour
-        // (need much memory for this !!!)
-        pthread_attr_setstacksize( & thread_attr, 32 * 1024 * 1024 );
-#endif
+        if (( status == EPERM ) && explicit_sched )
+        {
+            // not allowed to change scheduling: fall back to inherited policy
+            std::cerr << "(TThread) create : pthread_create ("
+                      << strerror( status ) << "), using inherited scheduling" << std::endl;
+
+            pthread_attr_setinheritsched( & thread_attr, PTHREAD_INHERIT_SCHED );
+            status = pthread_create( & _thread_id, & thread_attr, _run_thread, this );
+        }// if
         
-        if ((status = pthread_create( & _thread_id, & thread_attr, _run_thread, this ) != 0))
+        if ( status != 0 )
             std::cerr << "(TThread) create : pthread_create ("
                       << strerror( status ) << ")" << std::endl;
         else
-            _running = true;
+        {
+            _running  = true;
+            _joinable = ! detached;
+        }// else
 
         // remove attribute
         pthread_attr_destroy( & thread_attr );
@@ -151,20 +410,50 @@ TThread::create ( const bool  detached,
         std::cout << "(TThread) create : thread is already running" << std::endl;
 }
 
+//
+// apply attributes within thread
+//
+void
+TThread::apply_attr ()
+{
+#if defined(__linux__)
+    if ( ! _attr.name.empty() )
+    {
+        // kernel limits names to 16 characters including terminating zero
+        const std::string  name = _attr.name.substr( 0, 15 );
+        
+        pthread_setname_np( pthread_self(), name.c_str() );
+    }// if
+
+    if ( _attr.nice != 0 )
+    {
+        // nice value is a per-thread property on Linux
+        if ( setpriority( PRIO_PROCESS, id_t( syscall( SYS_gettid ) ), _attr.nice ) != 0 )
+            std::cerr << "(TThread) apply_attr : setpriority ("
+                      << strerror( errno ) << ")" << std::endl;
+    }// if
+#elif defined(__APPLE__)
+    if ( ! _attr.name.empty() )
+        pthread_setname_np( _attr.name.c_str() );
+#endif
+}
+
 //
 // detach thread
 //
 void 
 TThread::detach ()
 {
-    if ( _running )
+    if ( _joinable )
     {
         int status;
         
-        // detach thread
+        // detach thread (also if already finished to release its resources)
         if ((status = pthread_detach( _thread_id )) != 0)
             std::cerr << "(TThread) detach : pthread_detach ("
                       << strerror( status ) << ")" << std::endl;
+
+        _joinable = false;
     }// if
 }
 
@@ -174,7 +463,8 @@ TThread::detach ()
 void 
 TThread::join ()
 {
-    if ( _running )
+    // a finished thread has reset "_running" but still has to be joined
+    if ( _joinable )
     {
         int status;
     
@@ -183,7 +473,8 @@ TThread::join ()
             std::cerr << "(TThread) join : pthread_join ("
                       << strerror( status ) << ")" << std::endl;
 
-        _running = false;
+        _running  = false;
+        _joinable = false;
     }// if
 }
 
@@ -249,4 +540,64 @@ TThread::sleep ( const double sec )
     }// if
 }
 
+////////////////////////////////////////////
+//
+// condition variable
+//
+
+//
+// wait for signal or until monotonic time <t>
+//
+bool
+TCondition::wait_until ( const double  t )
+{
+    struct timespec  abs_time;
+
+#if defined(__linux__)
+    to_timespec( t, false, abs_time );
+#else
+    // condition uses the realtime clock
+    to_timespec( t, true, abs_time );
+#endif
+
+    return pthread_cond_timedwait( & _cond, & _mutex, & abs_time ) != ETIMEDOUT;
+}
+
+////////////////////////////////////////////
+//
+// mutex
+//
+
+//
+// lock mutex unless monotonic time <t> is reached
+//
+bool
+TMutex::lock_until ( const double  t )
+{
+    struct timespec  abs_time;
+
+#if defined(__linux__) && defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+    to_timespec( t, false, abs_time );
+    
+    return pthread_mutex_clocklock( & _mutex, CLOCK_MONOTONIC, & abs_time ) == 0;
+#elif defined(__APPLE__)
+    // no timed locking available: poll mutex
+    while ( pthread_mutex_trylock( & _mutex ) != 0 )
+    {
+        if ( monotonic_time() >= t )
+            return false;
+
+        abs_time.tv_sec  = 0;
+        abs_time.tv_nsec = 100000;
+        nanosleep( & abs_time, 0 );
+    }// while
+
+    return true;
+#else
+    to_timespec( t, true, abs_time );
+    
+    return pthread_mutex_timedlock( & _mutex, & abs_time ) == 0;
+#endif
+}
+
 }// namespace ThreadPool
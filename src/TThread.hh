@@ -8,11 +8,55 @@
 //
 
 #include <cstdio>
+#include <string>
+#include <time.h>
 #include <pthread.h>
 
 namespace ThreadPool
 {
 
+//! return time in seconds of a monotonic clock, e.g. for timeouts and deadlines
+double  monotonic_time ();
+
+//! return number of processors available to the process, e.g. restricted by
+//! the CPU affinity mask and the CPU quota of the cgroup (v1 and v2)
+unsigned int  available_cpus ();
+
+////////////////////////////////////////////////////////////
+//!
+//! \struct TThreadAttr
+//! \brief  attributes of a thread, which are applied on creation
+//!
+////////////////////////////////////////////////////////////
+
+struct TThreadAttr
+{
+    //! size of stack in bytes (0: system default)
+    size_t       stack_size;
+
+    //! size of guard area at end of stack in bytes (0: system default)
+    size_t       guard_size;
+
+    //! name of thread, e.g. as shown by "top -H" (empty: unchanged);
+    //! names are truncated to 15 characters on Linux
+    std::string  name;
+
+    //! scheduling policy, e.g. SCHED_FIFO, SCHED_RR (-1: inherit from creator)
+    int          sched_policy;
+
+    //! priority for scheduling policy
+    int          sched_priority;
+
+    //! nice value of thread (0: unchanged; Linux only)
+    int          nice;
+
+    //! construct attributes with system defaults
+    TThreadAttr ()
+            : stack_size( 0 ), guard_size( 0 ),
+              sched_policy( -1 ), sched_priority( 0 ), nice( 0 )
+    {}
+};
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 //!
@@ -34,8 +78,15 @@ protected:
     // is the thread running or not
     bool       _running;
 
+    // thread was created joinable and not yet joined or detached
+    // (not reset when thread finishes, see _run_thread)
+    bool       _joinable;
+
     // no of thread
-    int        _thread_no;
+    int          _thread_no;
+
+    // attributes of thread
+    TThreadAttr  _attr;
     
     //! @endcond
     
@@ -62,6 +113,12 @@ public:
     //! set thread number to \a n
     void set_thread_no ( const int  n );
 
+    //! return attributes of thread
+    const TThreadAttr &  attr () const { return _attr; }
+
+    //! set attributes \a attr used for next "create"
+    void set_attr ( const TThreadAttr &  attr ) { _attr = attr; }
+
     //! compare if processor number \a p is local one
     bool on_proc ( const int p ) const
     {
@@ -88,6 +145,8 @@ public:
     //!     the thread competes for resources with all other threads of all
     //!     processes on the system; if \a sscope is false, the competition is
     //!     only process local
+    //!   - thread attributes (see set_attr) are applied; if the scheduling
+    //!     policy may not be set, the thread is started with inherited policy
     void create ( const bool  detached = false,
                   const bool  sscope   = false );
 
@@ -123,6 +182,9 @@ public:
     
     //! resets running-status (used in _run_proc, see TThread.cc)
     void reset_running () { _running = false; }
+
+    //! apply attributes, which have to be set by thread itself (used in _run_proc)
+    void apply_attr    ();
     
     //! @endcond
 };
@@ -179,6 +241,13 @@ public:
     //! unlock mutex
     void  unlock  () { pthread_mutex_unlock( & _mutex ); }
 
+    //! try to lock mutex and return true on success
+    bool  try_lock () { return pthread_mutex_trylock( & _mutex ) == 0; }
+
+    //! lock mutex unless monotonic time \a t (see monotonic_time) is
+    //! reached before; return true if mutex was locked
+    bool  lock_until ( const double  t );
+
     //! return true if mutex is locked and false, otherwise
     bool is_locked ()
     {
@@ -256,8 +325,18 @@ public:
     // constructor and destructor
     //
 
-    //! ctor
-    TCondition  () { pthread_cond_init(    & _cond, NULL ); }
+    //! ctor (timed waits use the monotonic clock if available)
+    TCondition  ()
+    {
+        pthread_condattr_t  cond_attr;
+
+        pthread_condattr_init( & cond_attr );
+#if defined(__linux__)
+        pthread_condattr_setclock( & cond_attr, CLOCK_MONOTONIC );
+#endif
+        pthread_cond_init( & _cond, & cond_attr );
+        pthread_condattr_destroy( & cond_attr );
+    }
 
     //! dtor
     ~TCondition () { pthread_cond_destroy( & _cond ); }
@@ -270,6 +349,10 @@ public:
     //! wait for signal to arrive
     void wait      () { pthread_cond_wait( & _cond, & _mutex ); }
 
+    //! wait for signal to arrive or until monotonic time \a t (see
+    //! monotonic_time) is reached; return false on timeout
+    bool wait_until ( const double  t );
+
     //! restart one of the threads, waiting on the cond. variable
     void signal    () { pthread_cond_signal( & _cond ); }
 
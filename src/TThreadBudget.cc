@@ -0,0 +1,292 @@
+//
+//  Project : ThreadPool
+//  File    : TThreadBudget.cc
+//  Author  : Ronald Kriemann
+//  Purpose : budget of active threads shared by several thread pools
+//
+
+#include <iostream>
+#include <algorithm>
+
+#include "TThreadBudget.hh"
+
+namespace ThreadPool
+{
+
+const unsigned int  TThreadBudget::AUTO_SIZE;
+
+////////////////////////////////////////////
+//
+// constructor and destructor
+//
+
+TThreadBudget::TThreadBudget ( const unsigned int  n )
+        : _size( n == AUTO_SIZE ? available_cpus() : n ),
+          _reserved( 0 ), _active( 0 ), _waiters( 0 )
+{}
+
+TThreadBudget::~TThreadBudget ()
+{
+    TScopedLock  lock( _cond );
+
+    for ( size_t  i = 0; i < _shares.size(); i++ )
+    {
+        if ( _shares[i].used )
+        {
+            std::cerr << "(TThreadBudget) destructor : pool still attached" << std::endl;
+            break;
+        }// if
+    }// for
+}
+
+////////////////////////////////////////////
+//
+// access budget
+//
+
+//
+// return number of tokens in use
+//
+unsigned int
+TThreadBudget::active ()
+{
+    TScopedLock  lock( _cond );
+
+    return _active;
+}
+
+//
+// return number of tokens not reserved
+//
+unsigned int
+TThreadBudget::unreserved ()
+{
+    TScopedLock  lock( _cond );
+
+    return _size - _reserved;
+}
+
+////////////////////////////////////////////
+//
+// handling of tokens
+//
+
+//
+// attach pool
+//
+bool
+TThreadBudget::attach ( const unsigned int  min,
+                        const unsigned int  max,
+                        unsigned int &      id )
+{
+    TScopedLock  lock( _cond );
+
+    if ( _reserved + min > _size )
+        return false;
+
+    TShare  share;
+
+    share.min     = min;
+    share.max     = std::max( min, max );
+    share.active  = 0;
+    share.waiting = 0;
+    share.used    = true;
+    _reserved    += min;
+
+    // reuse id of detached pool
+    for ( id = 0; id < _shares.size(); id++ )
+    {
+        if ( ! _shares[id].used )
+        {
+            _shares[id] = share;
+            return true;
+        }// if
+    }// for
+
+    _shares.push_back( share );
+
+    return true;
+}
+
+//
+// change share of pool
+//
+bool
+TThreadBudget::set_share ( const unsigned int  id,
+                           const unsigned int  min,
+                           const unsigned int  max )
+{
+    TScopedLock  lock( _cond );
+    TShare &     share = _shares[id];
+
+    if ( _reserved - share.min + min > _size )
+        return false;
+
+    _reserved += min - share.min;
+    share.min  = min;
+    share.max  = std::max( min, max );
+
+    // waiting threads may use changed shares
+    if ( _waiters > 0 )
+        _cond.broadcast();
+
+    return true;
+}
+
+//
+// detach pool
+//
+void
+TThreadBudget::detach ( const unsigned int  id )
+{
+    TScopedLock  lock( _cond );
+
+    if ( _shares[id].active > 0 )
+        std::cerr << "(TThreadBudget) detach : tokens of pool still in use" << std::endl;
+
+    _reserved        -= _shares[id].min;
+    _shares[id].used  = false;
+
+    // tokens reserved for pool are available for others
+    if ( _waiters > 0 )
+        _cond.broadcast();
+}
+
+//
+// return true if pool may take a token
+//
+bool
+TThreadBudget::available ( const unsigned int  id ) const
+{
+    const TShare &  share = _shares[id];
+
+    if (( _active >= _size ) || ( share.active >= share.max ))
+        return false;
+
+    // any free token may be used for minimal share
+    if ( share.active < share.min )
+        return true;
+
+    // further tokens only if not needed by waiting threads of pools
+    // below their minimal share
+    return _size - _active > demand( id );
+}
+
+//
+// return number of tokens needed for minimal shares of other pools
+//
+unsigned int
+TThreadBudget::demand ( const unsigned int  id ) const
+{
+    unsigned int  n = 0;
+
+    for ( size_t  i = 0; i < _shares.size(); i++ )
+    {
+        const TShare &  other = _shares[i];
+
+        if (( i != id ) && other.used && ( other.active < other.min ))
+            n += std::min( other.waiting, other.min - other.active );
+    }// for
+
+    return n;
+}
+
+//
+// return true if token of pool is needed by waiting threads
+//
+bool
+TThreadBudget::must_yield ( const unsigned int  id )
+{
+    TScopedLock  lock( _cond );
+
+    return (( _shares[id].active > _shares[id].min ) || ( demand( id ) > 0 ));
+}
+
+//
+// account for waiting thread
+//
+void
+TThreadBudget::add_waiter ( const unsigned int  id )
+{
+    _shares[id].waiting++;
+    _waiters++;
+}
+
+void
+TThreadBudget::remove_waiter ( const unsigned int  id )
+{
+    _shares[id].waiting--;
+    _waiters--;
+}
+
+//
+// take token
+//
+void
+TThreadBudget::take ( const unsigned int  id )
+{
+    _shares[id].active++;
+    _active++;
+}
+
+//
+// take token if available
+//
+bool
+TThreadBudget::try_acquire ( const unsigned int  id )
+{
+    TScopedLock  lock( _cond );
+
+    if ( ! available( id ) )
+        return false;
+
+    take( id );
+
+    return true;
+}
+
+//
+// take token, wait until available
+//
+void
+TThreadBudget::acquire ( const unsigned int  id )
+{
+    TScopedLock  lock( _cond );
+
+    add_waiter( id );
+
+    while ( ! available( id ) )
+        _cond.wait();
+
+    remove_waiter( id );
+    take( id );
+}
+
+//
+// return token
+//
+void
+TThreadBudget::release ( const unsigned int  id )
+{
+    TScopedLock  lock( _cond );
+
+    _shares[id].active--;
+    _active--;
+
+    // waiting threads of several pools may use token
+    if ( _waiters > 0 )
+        _cond.broadcast();
+}
+
+//
+// wake all waiting threads
+//
+void
+TThreadBudget::wake ()
+{
+    TScopedLock  lock( _cond );
+
+    _cond.broadcast();
+}
+
+}// namespace ThreadPool
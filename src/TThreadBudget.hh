@@ -0,0 +1,164 @@
+#ifndef __TTHREADBUDGET_HH
+#define __TTHREADBUDGET_HH
+//
+//  Project : ThreadPool
+//  File    : TThreadBudget.hh
+//  Author  : Ronald Kriemann
+//  Purpose : budget of active threads shared by several thread pools
+//
+
+#include <vector>
+
+#include "TThread.hh"
+#include "TAtomic.hh"
+
+namespace ThreadPool
+{
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+//!
+//! \class  TThreadBudget
+//! \brief  limits the number of threads executing jobs in all attached
+//!         pools (see TPool::set_budget):
+//!         - a thread needs a token of the budget to execute a job and
+//!           otherwise blocks until a token is returned
+//!         - each pool is guaranteed a minimal number of tokens and may
+//!           use at most a maximal number of tokens
+//!         - tokens reserved for a pool but not used are available for
+//!           other pools, unless threads of the pool wait for them
+//!
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+class TThreadBudget
+{
+    friend class TPool;
+
+public:
+    //! number of tokens to choose budget by available processors
+    static const unsigned int  AUTO_SIZE = 0;
+
+protected:
+    //! @cond
+
+    // share of an attached pool
+    struct TShare
+    {
+        unsigned int  min, max;
+        unsigned int  active;
+        unsigned int  waiting;
+        bool          used;
+    };
+
+    // number of tokens
+    unsigned int           _size;
+
+    // sum of minimal shares of pools
+    unsigned int           _reserved;
+
+    // number of tokens in use
+    unsigned int           _active;
+
+    // number of threads waiting for a token
+    volatile unsigned int  _waiters;
+
+    // shares of attached pools (indexed by id of pool)
+    std::vector< TShare >  _shares;
+
+    // condition guarding above data and signalling returned tokens
+    TCondition             _cond;
+
+    // prevent copy operations
+    TThreadBudget ( const TThreadBudget & );
+    TThreadBudget & operator = ( const TThreadBudget & );
+
+    //! @endcond
+
+public:
+    /////////////////////////////////////////////////
+    //
+    // constructor and destructor
+    //
+
+    //! construct budget with \a n tokens (AUTO_SIZE: number of available
+    //! processors)
+    TThreadBudget ( const unsigned int  n = AUTO_SIZE );
+
+    //! dtor (all pools have to be detached)
+    ~TThreadBudget ();
+
+    /////////////////////////////////////////////////
+    //
+    // access budget
+    //
+
+    //! return number of tokens
+    unsigned int  size    () const { return _size; }
+
+    //! return number of tokens in use
+    unsigned int  active  ();
+
+    //! return number of tokens not reserved as minimal share of a pool
+    unsigned int  unreserved ();
+
+protected:
+    //! @cond
+
+    // attach pool with minimal share \a min and maximal share \a max and
+    // return its id in \a id; return false if \a min tokens are not
+    // available for reservation
+    bool  attach      ( const unsigned int  min,
+                        const unsigned int  max,
+                        unsigned int &      id );
+
+    // change minimal and maximal share of pool \a id; return false if
+    // \a min tokens are not available for reservation
+    bool  set_share   ( const unsigned int  id,
+                        const unsigned int  min,
+                        const unsigned int  max );
+
+    // detach pool with \a id (no token of pool may be in use)
+    void  detach      ( const unsigned int  id );
+
+    // return true if pool \a id may take a token (with _cond locked)
+    bool  available   ( const unsigned int  id ) const;
+
+    // return number of tokens needed by waiting threads of pools (other
+    // than \a id) below their minimal share (with _cond locked)
+    unsigned int  demand ( const unsigned int  id ) const;
+
+    // account for thread of pool \a id starting or stopping to wait for
+    // a token (with _cond locked)
+    void  add_waiter    ( const unsigned int  id );
+    void  remove_waiter ( const unsigned int  id );
+
+    // return true if threads wait for a token
+    bool  contended   () const { return atomic_load( _waiters ) > 0; }
+
+    // return true if a token of pool \a id is needed by waiting threads,
+    // e.g. if it exceeds the minimal share of the pool or other pools
+    // are below their minimal share
+    bool  must_yield  ( const unsigned int  id );
+
+    // take token for pool \a id (with _cond locked)
+    void  take        ( const unsigned int  id );
+
+    // take token for pool \a id if available; return true on success
+    bool  try_acquire ( const unsigned int  id );
+
+    // take token for pool \a id, wait until available
+    void  acquire     ( const unsigned int  id );
+
+    // return token of pool \a id and wake waiting threads
+    void  release     ( const unsigned int  id );
+
+    // wake all waiting threads, e.g. to recheck state of their pool
+    void  wake        ();
+
+    //! @endcond
+};
+
+}// namespace ThreadPool
+
+#endif  // __TTHREADBUDGET_HH
@@ -6,8 +6,17 @@
 //
 
 #include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <climits>
+#include <algorithm>
+#include <new>
+#include <sstream>
 
 #include "TThreadPool.hh"
+#include "TTimerWheel.hh"
+#include "TThreadBudget.hh"
+#include "TCompletionQueue.hh"
 
 namespace ThreadPool
 {
@@ -17,6 +26,7 @@ namespace
 
 //
 // set to one to enable sequential execution, e.g. for debugging
+// (default for all pools, see TPool::set_sequential)
 //
 #define THR_SEQUENTIAL  0
 
@@ -25,6 +35,33 @@ namespace
 //
 TPool * thread_pool = NULL;
 
+//
+// key for thread specific pointer to thread of pool
+//
+pthread_key_t   worker_key;
+pthread_once_t  worker_once = PTHREAD_ONCE_INIT;
+
+void
+create_worker_key ()
+{
+    pthread_key_create( & worker_key, NULL );
+}
+
+//
+// predicates for purging the job queue
+//
+bool
+is_job ( const TPool::TJob * job, const void * arg )
+{
+    return job == arg;
+}
+
+bool
+in_group ( const TPool::TJob * job, const void * arg )
+{
+    return job->group() == arg;
+}
+
 }// namespace anonymous
 
 //////////////////////////////////////////////////////////////////////////
@@ -44,315 +81,2273 @@ class TPoolThr : public TThread
 protected:
     // pool we are in
     TPool *        _pool;
-    
-    // job to run and data for it
-    TPool::TJob *  _job;
-    void *         _data_ptr;
 
-    // should the job be deleted upon completion
-    bool           _del_job;
-    
-    // condition for job-waiting
-    TCondition     _work_cond;
-    
-    // indicates end-of-thread
-    bool           _end;
+    // arena for temporary memory of jobs (created on demand)
+    TArena *       _arena;
 
-    // mutex for preventing premature deletion
-    TMutex         _del_mutex;
+    // data of worker-local slots
+    std::vector< void * >  _slot_data;
+
+    // indicates token of thread budget of pool held by thread
+    bool           _token;
     
 public:
     //
     // constructor
     //
     TPoolThr ( const int n, TPool * p )
-            : TThread(n), _pool(p), _job(NULL), _data_ptr(NULL), _del_job(false), _end(false)
+            : TThread(n), _pool(p), _arena(NULL), _token(false)
     {}
     
-    ~TPoolThr () {}
+    ~TPoolThr () { delete _arena; }
+
+    //
+    // return pool of thread
+    //
+    TPool * pool () { return _pool; }
+
+    //
+    // return true if thread holds token of thread budget
+    //
+    bool token () const { return _token; }
+
+    //
+    // return arena of thread
+    //
+    TArena * arena ()
+    {
+        if ( _arena == NULL )
+            _arena = new TArena( _pool->_arena_size, _pool->_arena_huge );
+
+        return _arena;
+    }
+
+    //
+    // return data of worker-local slot, initialise missing slots
+    //
+    void * slot ( const unsigned int  id )
+    {
+        if ( id < _slot_data.size() )
+            return _slot_data[ id ];
+
+        std::vector< TPool::TSlot >  slots;
+
+        {
+            TScopedLock  lock( _pool->_slot_mutex );
+
+            slots = _pool->_slots;
+        }
+
+        if ( id >= slots.size() )
+            return NULL;
+
+        // slots are initialised in order of registration
+        for ( unsigned int  i = _slot_data.size(); i <= id; i++ )
+        {
+            if ( slots[i].init != NULL )
+                _slot_data.push_back( slots[i].init( thread_no(), slots[i].arg ) );
+            else
+                _slot_data.push_back( NULL );
+        }// for
+
+        return _slot_data[ id ];
+    }
+
+    //
+    // release data of all worker-local slots (in reverse order)
+    //
+    void release_slots ()
+    {
+        std::vector< TPool::TSlot >  slots;
+
+        {
+            TScopedLock  lock( _pool->_slot_mutex );
+
+            slots = _pool->_slots;
+        }
+
+        while ( ! _slot_data.empty() )
+        {
+            const unsigned int  i = _slot_data.size() - 1;
+
+            if ( slots[i].done != NULL )
+                slots[i].done( _slot_data[i], slots[i].arg );
+
+            _slot_data.pop_back();
+        }// while
+    }
     
     //
     // parallel running method
     //
     void run ()
     {
-        TScopedLock  del_lock( _del_mutex );
+        pthread_once( & worker_once, create_worker_key );
+        pthread_setspecific( worker_key, this );
+        
+        // start further threads (recursively) if requested
+        if ( _pool->_startup == TPool::STARTUP_PARALLEL )
+        {
+            _pool->spawn();
+            _pool->spawn();
+        }// if
+
+        // initialise all registered worker-local slots
+        {
+            unsigned int  nslots;
+            
+            {
+                TScopedLock  lock( _pool->_slot_mutex );
+
+                nslots = _pool->_slots.size();
+            }
 
-        while ( ! _end )
+            if ( nslots > 0 )
+                slot( nslots-1 );
+        }
+        
+        TPool::TJob *  job = _pool->dequeue( thread_no(), false, false, false, _token );
+        
+        while ( job != NULL )
         {
             //
-            // append thread to idle-list and wait for work
+            // execute job
             //
 
-            _pool->append_idle( this );
+            // drop job if cancelled while waiting in queue
+            TPool::TJobGroup *  group     = job->group();
+            const bool          cancelled = job->is_cancelled();
+            const double        deadline  = job->deadline();
+            bool                missed    = false;
+            
+            if ( cancelled )
+                TPool::drop( job );
+            else
+            {
+                job->run( job->_pool_arg );
+                TPool::finish( job, job->_pool_del );
+
+                missed = (( deadline > 0.0 ) && ( monotonic_time() > deadline ));
+            }// else
+
+            if ( group != NULL )
+                group->finish_job();
+
+            // release temporary memory of job
+            if ( _arena != NULL )
+                _arena->reset();
+            
+            job = _pool->dequeue( thread_no(), true, ! cancelled, missed, _token );
+        }// while
+
+        release_slots();
+    }
+};
+    
+namespace
+{
+
+//
+// return pool thread executing calling function (or NULL)
+//
+TPoolThr *
+current_thread ()
+{
+    pthread_once( & worker_once, create_worker_key );
+
+    return static_cast< TPoolThr * >( pthread_getspecific( worker_key ) );
+}
+
+//
+// return size of memory of a pool thread, e.g. padded to cache lines to
+// avoid false sharing between threads (and with other data)
+//
+inline size_t
+thread_stride ()
+{
+    return (( sizeof( TPoolThr ) + CACHE_LINE_SIZE - 1 ) / CACHE_LINE_SIZE ) * CACHE_LINE_SIZE;
+}
+
+//
+// finish thread constructed in memory of pool
+//
+inline void
+destroy ( TPoolThr *  thr )
+{
+    thr->~TPoolThr();
+}
+
+//
+// return true if waiting threads may spin, e.g. not on a single
+// processor where spinning only delays the thread to wait for
+//
+bool
+may_spin ()
+{
+    static const bool  spin = ( available_cpus() > 1 );
+
+    return spin;
+}
+
+//
+// job executing function of "run_on_all" with given rank
+//
+class TSPMDJob : public TPool::TJob
+{
+protected:
+    TPool::spmd_func_t   _func;
+    const unsigned int   _rank, _nthreads;
+
+public:
+    TSPMDJob ( TPool::spmd_func_t  func,
+               const unsigned int  rank,
+               const unsigned int  nthreads )
+            : _func( func ), _rank( rank ), _nthreads( nthreads )
+    {}
+
+    void run ( void *  arg )
+    {
+        _func( _rank, _nthreads, arg );
+    }
+};
+
+}// namespace anonymous
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+//
+// ThreadPool - implementation
+//
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
+const unsigned int  TPool::AUTO_SIZE;
+
+//
+// constructor and destructor
+//
+
+TPool::TPool ( const unsigned int   max_p,
+               const TThreadAttr &  attr,
+               const startup_t      startup )
+        : _max_parallel( max_p == AUTO_SIZE ? available_cpus() : max_p ),
+          _started( 0 ), _startup( startup ), _saturation( SATURATION_BLOCK ), _max_queued( 0 ),
+          _capacity( 0 ), _schedule( SCHEDULE_FIFO ), _sequential( THR_SEQUENTIAL == 1 ),
+          _wait( WAIT_PARK ), _spins( 0 ), _yields( 0 ),
+          _arena_size( 1024*1024 ), _arena_huge( false ), _max_spare( _max_parallel ),
+          _budget( NULL ), _budget_id( 0 ), _completion( NULL ),
+          _tune( false ), _tune_min( 1 ), _tune_max( UINT_MAX ), _tune_interval( 0.1 ),
+          _queue_head( NULL ), _queue_tail( NULL ),
+          _tenant_cursor( 0 ), _tenant_jobs( 0 ), _queue_size( 0 ), _queue_seq( 0 ), _busy( 0 ),
+          _submitters( 0 ), _sync_waiters( 0 ), _end( false ), _down( false ),
+          _tune_time( 0.0 ), _tune_next( 0.0 ), _tune_executed( 0 ), _tune_throughput( 0.0 ), _tune_dir( 1 ),
+          _spinning( 0 ), _blocked( 0 ), _active_limit( UINT_MAX ),
+          _threads( NULL ), _thread_slots( 0 ), _attr( attr ),
+          _spawning( 0 ), _spawn_closed( false ), _spmd_barrier( NULL ),
+          _spare_exit( false ), _timers( NULL )
+{
+    grow_threads( _max_parallel + _max_spare );
+
+    // default tenant
+    add_tenant( 1 );
+    
+    //
+    // start threads for pool
+    //
+
+    switch ( _startup )
+    {
+        case STARTUP_EAGER    : while ( spawn() ) ; break;
+        case STARTUP_PARALLEL : spawn(); break;
+        case STARTUP_LAZY     : break;
+    }// switch
+
+    // tell the scheduling system, how many threads to expect
+    // (commented out since not needed on most systems)
+//     if ( pthread_setconcurrency( _max_parallel + pthread_getconcurrency() ) != 0 )
+//         std::cerr << "(TPool) TPool : pthread_setconcurrency ("
+//                   << strerror( status ) << ")" << std::endl;
+}
+
+TPool::~TPool ()
+{
+    shutdown( SHUTDOWN_DRAIN );
+
+    if ( _budget != NULL )
+        _budget->detach( _budget_id );
+
+    delete[] _threads;
+
+    for ( size_t  i = 0; i < _thread_blocks.size(); i++ )
+        free( _thread_blocks[i].mem );
+}
+
+//
+// finish all threads
+//
+void
+TPool::shutdown ( const shutdown_t  mode )
+{
+    TTimerWheel *  wheel;
+    TJob *         dropped = NULL;
+
+    // serialise with "resize" and "run_on_all", e.g. jobs of "run_on_all"
+    // are either all queued before the end of the pool or not at all
+    TScopedLock    resize_lock( _resize_mutex );
+    
+    {
+        TScopedLock  lock( _timer_mutex );
+
+        if ( _end )
+            return;
+        
+        // stop creation of new timers
+        wheel  = _timers;
+        _timers = NULL;
+
+        // from now on, threads finish if queue is empty
+        TScopedLock  work_lock( _work_mutex );
+
+        _end = true;
+    }
+
+    // stop timer thread and drop pending timers
+    delete wheel;
+
+    //
+    // wake up all threads at once
+    //
+    
+    {
+        TScopedLock  lock( _work_mutex );
+
+        if ( mode == SHUTDOWN_DISCARD )
+        {
+            _stats.dropped += _queue_size;
+            dropped     = _queue_head;
+            _queue_head = _queue_tail = NULL;
+            _queue_size = 0;
+
+            for ( size_t  i = 0; i < _deadline_queue.size(); i++ )
+            {
+                _deadline_queue[i]->_pool_next = dropped;
+                dropped = _deadline_queue[i];
+            }// for
+
+            _deadline_queue.clear();
+
+            for ( size_t  i = 0; i < _tenants.size(); i++ )
+            {
+                TTenant &  tenant = _tenants[i];
+                
+                if ( tenant.head != NULL )
+                {
+                    tenant.tail->_pool_next = dropped;
+                    dropped = tenant.head;
+                }// if
+
+                tenant.head          = tenant.tail = NULL;
+                tenant.deficit       = 0;
+                tenant.stats.dropped += tenant.stats.queued;
+                tenant.stats.queued  = 0;
+            }// for
+
+            _tenant_jobs = 0;
+        }// if
+    }
+
+    _work_event.notify_all();
+
+    // wake parked spare threads (they finish)
+    {
+        TScopedLock  lock( _spare_cond );
+
+        _spare_cond.broadcast();
+    }
+
+    // wake threads waiting for a token of the budget
+    if ( _budget != NULL )
+        _budget->wake();
+    
+    // wake threads waiting for space in queue
+    {
+        TScopedLock  lock( _space_cond );
+
+        _space_cond.broadcast();
+    }
+    
+    while ( dropped != NULL )
+    {
+        TJob *       next  = dropped->_pool_next;
+        TJobGroup *  group = dropped->group();
+
+        dropped->_pool_next = NULL;
+        drop( dropped );
+        
+        if ( group != NULL )
+            group->finish_job();
+        
+        dropped = next;
+    }// while
+
+    //
+    // wait for threads to finish running (or queued) jobs
+    //
+
+    unsigned int  started;
+
+    {
+        TScopedLock  lock( _thread_cond );
+
+        // no new threads from now on, wait for threads being created
+        _spawn_closed = true;
+
+        while ( _spawning > 0 )
+            _thread_cond.wait();
+
+        started = _started;
+    }
+    
+    for ( unsigned int  i = 0; i < started; i++ )
+    {
+        _threads[i]->join();
+        destroy( _threads[i] );
+        _threads[i] = NULL;
+    }// for
+
+    {
+        TScopedLock  lock( _work_mutex );
+
+        _down = true;
+    }
+
+    // wake threads waiting for space in queue (job is rejected)
+    {
+        TScopedLock  lock( _space_cond );
+
+        _space_cond.broadcast();
+    }
+    
+    // wake threads waiting in sync_all
+    TScopedLock  lock( _idle_cond );
+        
+    _idle_cond.broadcast();
+}
+
+//
+// change number of threads
+//
+void
+TPool::resize ( const unsigned int  max_p )
+{
+    const unsigned int  n = ( max_p == AUTO_SIZE ? available_cpus() : max_p );
+    TScopedLock         resize_lock( _resize_mutex );
+    unsigned int        started;
+
+    {
+        TScopedLock  lock( _thread_cond );
+
+        if ( _spawn_closed )
+            return;
+
+        while ( _spawning > 0 )
+            _thread_cond.wait();
+
+        started = _started;
+
+        {
+            TScopedLock  work_lock( _work_mutex );
+
+            _max_parallel = n;
+
+            // spare threads beyond new size finish instead of parking
+            _spare_exit = ( n < started );
+        }
+
+        grow_threads( n + _max_spare );
+    }
+
+    // wake parked spare threads (to finish or to work as regular threads)
+    {
+        TScopedLock  lock( _spare_cond );
+
+        _spare_cond.broadcast();
+    }
+
+    // wake threads waiting for a token of the budget (surplus threads finish)
+    if ( _budget != NULL )
+        _budget->wake();
+    
+    if ( n < started )
+    {
+        //
+        // wake idle threads, surplus threads finish after current job
+        //
+
+        _work_event.notify_all();
+        
+        for ( unsigned int  i = n; i < started; i++ )
+        {
+            _threads[i]->join();
+            destroy( _threads[i] );
+        }// for
+
+        TScopedLock  lock( _thread_cond );
+
+        for ( unsigned int  i = n; i < started; i++ )
+            _threads[i] = NULL;
+        
+        atomic_store( _started, n );
+        atomic_store( _spare_exit, false );
+    }// if
+    else if ( _startup != STARTUP_LAZY )
+    {
+        while ( spawn() ) ;
+    }// if
+}
+
+//
+// start another thread
+//
+bool
+TPool::spawn ( const unsigned int  spares )
+{
+    TPoolThr *    thr;
+    unsigned int  i;
+    
+    {
+        TScopedLock  lock( _thread_cond );
+
+        // no spare threads while surplus threads finish in "resize"
+        if ( _spawn_closed || _spare_exit ||
+             ( _started >= _max_parallel + spares ) || ( _started >= _thread_slots ))
+            return false;
+
+        // reserve slot, thread is created without lock to allow
+        // parallel creation of threads
+        i   = _started;
+        thr = new ( thread_memory( i ) ) TPoolThr( i, this );
+        _threads[i] = thr;
+        _spawning++;
+        atomic_store( _started, i+1 );
+    }
+
+    TThreadAttr  thr_attr( _attr );
+
+    if ( ! thr_attr.name.empty() )
+    {
+        std::ostringstream  name;
+
+        name << _attr.name << '-' << i;
+        thr_attr.name = name.str();
+    }// if
+            
+    thr->set_attr( thr_attr );
+    thr->create( false, true );
+
+    TScopedLock  lock( _thread_cond );
+
+    if ( --_spawning == 0 )
+        _thread_cond.broadcast();
+    
+    return true;
+}
+
+//
+// extend array of threads
+//
+void
+TPool::grow_threads ( const unsigned int  nslots )
+{
+    if ( nslots <= _thread_slots )
+        return;
+
+    //
+    // memory of all new threads as one block, threads in existing
+    // blocks may be running and are not moved
+    //
+    
+    void *  mem = NULL;
+
+    if ( posix_memalign( & mem, CACHE_LINE_SIZE, ( nslots - _thread_slots ) * thread_stride() ) != 0 )
+        throw std::bad_alloc();
+
+    TThreadBlock  block;
+
+    block.mem   = static_cast< char * >( mem );
+    block.first = _thread_slots;
+    _thread_blocks.push_back( block );
+
+    TPoolThr **  threads = new TPoolThr*[ nslots ];
+
+    for ( unsigned int  i = 0; i < nslots; i++ )
+        threads[i] = ( i < _thread_slots ? _threads[i] : NULL );
+
+    delete[] _threads;
+    _threads      = threads;
+    _thread_slots = nslots;
+}
+
+//
+// return memory of thread in given slot
+//
+void *
+TPool::thread_memory ( const unsigned int  i ) const
+{
+    // blocks are ordered by first slot
+    size_t  b = _thread_blocks.size() - 1;
+
+    while ( _thread_blocks[b].first > i )
+        b--;
+
+    return _thread_blocks[b].mem + ( i - _thread_blocks[b].first ) * thread_stride();
+}
+
+//
+// return true if thread may not execute jobs
+//
+bool
+TPool::retired ( const unsigned int  thr_no ) const
+{
+    const unsigned int  max_p = atomic_load( _max_parallel );
+
+    if ( thr_no < std::min( max_p, atomic_load( _active_limit ) ))
+        return false;
+
+    // parked by auto-tuning (except in "run_on_all" which needs all threads)
+    if ( thr_no < max_p )
+        return ( atomic_load( _spmd_barrier ) == NULL );
+
+    // spare threads are active while threads are blocked
+    if ( atomic_load( _spare_exit ) )
+        return true;
+
+    const unsigned int  spares = std::min< unsigned int >( atomic_load( _blocked ),
+                                                            atomic_load( _max_spare ) );
+    
+    return thr_no >= max_p + spares;
+}
+
+//
+// return true if retired thread finishes
+//
+bool
+TPool::exiting ( const unsigned int  thr_no ) const
+{
+    return ( atomic_load( _end ) ||
+             ( atomic_load( _spare_exit ) && ( thr_no >= atomic_load( _max_parallel ) )));
+}
+
+//
+// account for thread entering blocking region and activate spare thread
+//
+void
+TPool::enter_blocking ( const bool  token )
+{
+    {
+        TScopedLock  lock( _work_mutex );
+
+        _stats.blocking_regions++;
+    }
+
+    // blocked thread needs no token
+    if ( token )
+        _budget->release( _budget_id );
+
+    const unsigned int  spares = std::min< unsigned int >( atomic_add( _blocked, 1 ),
+                                                            atomic_load( _max_spare ) );
+
+    if ( spares == 0 )
+        return;
+
+    // wake parked spare thread or start new one
+    {
+        TScopedLock  lock( _spare_cond );
+
+        _spare_cond.broadcast();
+    }
+
+    if ( atomic_load( _started ) < atomic_load( _max_parallel ) + spares )
+        spawn( spares );
+}
+
+//
+// account for thread leaving blocking region (surplus spare thread is
+// parked after its current job)
+//
+void
+TPool::leave_blocking ( const bool  token )
+{
+    atomic_add( _blocked, -1 );
+
+    if ( token )
+        _budget->acquire( _budget_id );
+}
+
+//
+// set budget of active threads
+//
+bool
+TPool::set_budget ( TThreadBudget *     budget,
+                    const unsigned int  min_threads,
+                    const unsigned int  max_threads )
+{
+    TScopedLock   lock( _work_mutex );
+    unsigned int  id = 0;
+
+    if ( budget == _budget )
+        return (( budget == NULL ) || budget->set_share( _budget_id, min_threads, max_threads ));
+    
+    if (( budget != NULL ) && ! budget->attach( min_threads, max_threads, id ))
+        return false;
+
+    if ( _budget != NULL )
+        _budget->detach( _budget_id );
+
+    _budget    = budget;
+    _budget_id = id;
+
+    return true;
+}
+
+//
+// set maximal number of spare threads
+//
+void
+TPool::set_max_spare ( const unsigned int  n )
+{
+    {
+        TScopedLock  resize_lock( _resize_mutex );
+        TScopedLock  lock( _thread_cond );
+
+        while ( _spawning > 0 )
+            _thread_cond.wait();
+
+        grow_threads( _max_parallel + n );
+
+        atomic_store( _max_spare, n );
+    }
+
+    // let spare threads apply new limit
+    TScopedLock  lock( _spare_cond );
+
+    _spare_cond.broadcast();
+}
+
+//
+// enable auto-tuning of number of active threads
+//
+void
+TPool::set_auto_tune ( const bool          enable,
+                       const unsigned int  min_threads,
+                       const unsigned int  max_threads,
+                       const double        interval )
+{
+    {
+        TScopedLock   lock( _work_mutex );
+        const double  now = monotonic_time();
+        
+        _tune          = enable;
+        _tune_min      = std::max( min_threads, 1u );
+        _tune_max      = std::max( max_threads, _tune_min );
+        _tune_interval = ( interval > 0.0 ? interval : 0.1 );
+
+        // start with all allowed threads
+        if ( enable )
+            atomic_store( _active_limit, std::min( _max_parallel, _tune_max ) );
+        else
+            atomic_store( _active_limit, UINT_MAX );
+
+        _tune_time       = now;
+        _tune_next       = now + _tune_interval;
+        _tune_executed   = _stats.executed;
+        _tune_throughput = 0.0;
+        _tune_dir        = 1;
+    }
+
+    // let parked threads apply new limit
+    TScopedLock  lock( _spare_cond );
+
+    _spare_cond.broadcast();
+}
+
+//
+// return number of active threads
+//
+unsigned int
+TPool::active_limit () const
+{
+    return std::min( atomic_load( _max_parallel ), atomic_load( _active_limit ) );
+}
+
+//
+// adjust number of active threads by hill climbing
+//
+bool
+TPool::tune ( const double  now )
+{
+    const double  throughput = double( _stats.executed - _tune_executed ) / ( now - _tune_time );
+    bool          activated  = false;
+
+    // without queued jobs, throughput is limited by submission
+    if ( _queue_size > 0 )
+    {
+        const unsigned int  lo = std::min( _tune_min, _max_parallel );
+        const unsigned int  hi = std::max( lo, std::min( _tune_max, _max_parallel ));
+        unsigned int        n  = std::max( lo, std::min( hi, atomic_load( _active_limit ) ));
+
+        // reverse direction if last step decreased throughput (beyond noise)
+        // or at bounds
+        if ( throughput < 0.95 * _tune_throughput )
+            _tune_dir = -_tune_dir;
+
+        if ((( _tune_dir > 0 ) && ( n >= hi )) || (( _tune_dir < 0 ) && ( n <= lo )))
+            _tune_dir = -_tune_dir;
+
+        if (( _tune_dir > 0 ) && ( n < hi ))
+        {
+            n++;
+            _stats.tune_increases++;
+            activated = true;
+        }// if
+        else if (( _tune_dir < 0 ) && ( n > lo ))
+        {
+            n--;
+            _stats.tune_decreases++;
+        }// if
+
+        atomic_store( _active_limit, n );
+    }// if
+
+    _tune_time       = now;
+    _tune_next       = now + _tune_interval;
+    _tune_executed   = _stats.executed;
+    _tune_throughput = throughput;
+
+    return activated;
+}
+
+///////////////////////////////////////////////
+//
+// blocking regions of jobs
+//
+
+TPool::TBlockingRegion::TBlockingRegion ()
+        : _pool( NULL ), _token( false )
+{
+    TPoolThr *  thr = current_thread();
+
+    if ( thr != NULL )
+    {
+        _pool  = thr->pool();
+        _token = thr->token();
+        _pool->enter_blocking( _token );
+    }// if
+}
+
+TPool::TBlockingRegion::~TBlockingRegion ()
+{
+    if ( _pool != NULL )
+        _pool->leave_blocking( _token );
+}
+
+///////////////////////////////////////////////
+//
+// access local variables
+//
+
+void
+TPool::set_capacity ( const unsigned int  n )
+{
+    _capacity = n;
+
+    // wake threads waiting for space (limit may have changed)
+    TScopedLock  lock( _space_cond );
+
+    _space_cond.broadcast();
+}
+
+//
+// set wait strategy of idle threads
+//
+void
+TPool::set_wait_strategy ( const wait_t        strategy,
+                           const unsigned int  spins,
+                           const unsigned int  yields )
+{
+    {
+        TScopedLock  lock( _work_mutex );
+    
+        _wait   = strategy;
+        _spins  = spins;
+        _yields = yields;
+    }
+    
+    // let blocked threads apply new strategy
+    if ( strategy == WAIT_BUSY )
+        _work_event.notify_all();
+}
+
+//
+// set parameters of arenas of threads
+//
+void
+TPool::set_arena ( const size_t  chunk_size,
+                   const bool    huge_pages )
+{
+    _arena_size = chunk_size;
+    _arena_huge = huge_pages;
+}
+
+//
+// return arena of calling thread
+//
+TArena *
+TPool::worker_arena ()
+{
+    TPoolThr *  thr = current_thread();
+
+    if ( thr == NULL )
+        return NULL;
+
+    return thr->arena();
+}
+
+//
+// register worker-local slot
+//
+unsigned int
+TPool::add_slot ( slot_init_t  init,
+                  slot_done_t  done,
+                  void *       arg )
+{
+    TScopedLock  lock( _slot_mutex );
+    TSlot        slot;
+
+    slot.init = init;
+    slot.done = done;
+    slot.arg  = arg;
+    _slots.push_back( slot );
+
+    return _slots.size() - 1;
+}
+
+//
+// return data of worker-local slot of calling thread
+//
+void *
+TPool::worker_slot ( const unsigned int  id )
+{
+    TPoolThr *  thr = current_thread();
+
+    if ( thr == NULL )
+        return NULL;
+
+    return thr->slot( id );
+}
+
+//
+// return number of calling thread
+//
+int
+TPool::worker_index ()
+{
+    TPoolThr *  thr = current_thread();
+
+    if ( thr == NULL )
+        return -1;
+
+    return thr->thread_no();
+}
+
+//
+// return/reset statistics
+//
+TPool::TStats
+TPool::stats ()
+{
+    TScopedLock  lock( _work_mutex );
+    TStats       stats( _stats );
+
+    stats.active_limit = active_limit();
+    
+    return stats;
+}
+
+void
+TPool::reset_stats ()
+{
+    TScopedLock  lock( _work_mutex );
+
+    _stats = TStats();
+}
+
+void
+TPool::set_schedule ( const schedule_t  schedule )
+{
+    TScopedLock  lock( _work_mutex );
+
+    _schedule = schedule;
+}
+
+unsigned int
+TPool::add_tenant ( const unsigned int  weight )
+{
+    TScopedLock  lock( _work_mutex );
+    TTenant      tenant;
+
+    tenant.head    = NULL;
+    tenant.tail    = NULL;
+    tenant.weight  = ( weight > 0 ? weight : 1 );
+    tenant.deficit = 0;
+    _tenants.push_back( tenant );
+
+    return _tenants.size() - 1;
+}
+
+void
+TPool::set_tenant_weight ( const unsigned int  id,
+                           const unsigned int  weight )
+{
+    TScopedLock  lock( _work_mutex );
+
+    if ( id < _tenants.size() )
+        _tenants[ id ].weight = ( weight > 0 ? weight : 1 );
+}
+
+unsigned int
+TPool::tenants ()
+{
+    TScopedLock  lock( _work_mutex );
+
+    return _tenants.size();
+}
+
+TPool::TTenantStats
+TPool::tenant_stats ( const unsigned int  id )
+{
+    TScopedLock  lock( _work_mutex );
+
+    if ( id < _tenants.size() )
+        return _tenants[ id ].stats;
+
+    return TTenantStats();
+}
+
+void
+TPool::set_saturation ( const saturation_t  policy,
+                        const unsigned int  max_queued )
+{
+    _saturation = policy;
+    _max_queued = max_queued;
+
+    // wake threads waiting for space (limit may have changed)
+    TScopedLock  lock( _space_cond );
+
+    _space_cond.broadcast();
+}
+
+///////////////////////////////////////////////
+//
+// run, stop and synch with job
+//
+
+bool
+TPool::run ( TPool::TJob * job, void * ptr, const bool del )
+{
+    if ( job == NULL )
+        return false;
+
+    // lock job for synchronisation and reset cancellation from former run
+    job->lock();
+    atomic_store( job->_cancelled, 0 );
+
+    if ( _sequential )
+    {
+        //
+        // run in calling thread
+        //
+    
+        run_inline( job, ptr, del );
+        return true;
+    }// if
+    
+    //
+    // run in parallel thread, e.g. append job to queue
+    //
+
+    push_t  res = push( job, ptr, del, queue_limit( true ) );
+
+    if ( res == PUSH_FULL )
+    {
+        switch ( _saturation )
+        {
+            case SATURATION_CALLER_RUNS :
+            {
+                TScopedLock  lock( _work_mutex );
+
+                _stats.submitted++;
+                _stats.caller_runs++;
+            }
+                
+                run_inline( job, ptr, del );
+                return true;
+
+            case SATURATION_REJECT :
+                break;
+                
+            case SATURATION_BLOCK :
+            default :
+                res = push_wait( job, ptr, del, true, -1.0 );
+        }// switch
+    }// if
+
+    if ( res == PUSH_OK )
+        return true;
+
+    return reject( job, res, "run" );
+}
+
+//
+// run job if queue is not full
+//
+bool
+TPool::try_run ( TPool::TJob * job, void * ptr, const bool del )
+{
+    if ( job == NULL )
+        return false;
+
+    job->lock();
+    atomic_store( job->_cancelled, 0 );
+
+    const push_t  res = push( job, ptr, del, queue_limit( false ) );
+    
+    if ( res == PUSH_OK )
+        return true;
+
+    return reject( job, res, "try_run" );
+}
+
+//
+// run job, wait for space in queue for given time
+//
+bool
+TPool::run_for ( TPool::TJob *  job,
+                 const double   timeout,
+                 void *         ptr,
+                 const bool     del )
+{
+    if ( job == NULL )
+        return false;
+
+    job->lock();
+    atomic_store( job->_cancelled, 0 );
+
+    push_t  res = push( job, ptr, del, queue_limit( false ) );
+
+    if (( res == PUSH_FULL ) && ( timeout > 0.0 ))
+        res = push_wait( job, ptr, del, false, monotonic_time() + timeout );
+    
+    if ( res == PUSH_OK )
+        return true;
+
+    return reject( job, res, "run_for" );
+}
+
+//
+// wait until <job> was executed
+//
+void
+TPool::sync ( TJob * job )
+{
+    if ( job == NULL )
+        return;
+
+    //
+    // spin or yield before blocking
+    //
+    
+    if (( _wait != WAIT_PARK ) && may_spin() )
+    {
+        const bool  busy = ( _wait == WAIT_BUSY );
+        
+        for ( unsigned int  i = 0; busy || ( i < _spins + _yields ); i++ )
+        {
+            if ( job->try_lock() )
+            {
+                job->unlock();
+                return;
+            }// if
+
+            if ( busy || ( i < _spins ) )
+                cpu_relax();
+            else
+                sched_yield();
+        }// for
+    }// if
+    
+    job->lock();
+    job->unlock();
+}
+
+//
+// wait until all jobs have been executed
+//
+void
+TPool::sync_all ()
+{
+    TScopedLock  lock( _idle_cond );
+
+    {
+        TScopedLock  work_lock( _work_mutex );
+
+        _sync_waiters++;
+    }
+    
+    while ( true )
+    {
+        {
+            TScopedLock  work_lock( _work_mutex );
+
+            if (( _queue_size == 0 ) && ( _busy == 0 ))
+            {
+                _sync_waiters--;
+                break;
+            }// if
+        }
+
+        // wait until all jobs have finished
+        _idle_cond.wait();
+    }// while
+}
+
+//
+// wait until all jobs of group were executed
+//
+void
+TPool::sync ( TJobGroup & group )
+{
+    TScopedLock  lock( group._sync_cond );
+
+    while ( group._pending > 0 )
+        group._sync_cond.wait();
+}
+
+//
+// timed synchronisation with job
+//
+TPool::sync_t
+TPool::sync_for ( TJob *        job,
+                  const double  timeout )
+{
+    return sync_until( job, monotonic_time() + timeout );
+}
+
+TPool::sync_t
+TPool::sync_until ( TJob *        job,
+                    const double  deadline )
+{
+    if ( job == NULL )
+        return SYNC_FINISHED;
+
+    if ( ! job->_sync_mutex.lock_until( deadline ) )
+        return SYNC_TIMEOUT;
+    
+    job->unlock();
+
+    return SYNC_FINISHED;
+}
+
+//
+// timed synchronisation with group
+//
+TPool::sync_t
+TPool::sync_for ( TJobGroup &   group,
+                  const double  timeout )
+{
+    return sync_until( group, monotonic_time() + timeout );
+}
+
+TPool::sync_t
+TPool::sync_until ( TJobGroup &   group,
+                    const double  deadline )
+{
+    TScopedLock  lock( group._sync_cond );
+
+    while ( group._pending > 0 )
+    {
+        if ( ! group._sync_cond.wait_until( deadline ) )
+            return ( group._pending > 0 ? SYNC_TIMEOUT : SYNC_FINISHED );
+    }// while
+
+    return SYNC_FINISHED;
+}
+
+//
+// timed synchronisation with all jobs
+//
+TPool::sync_t
+TPool::sync_all_for ( const double  timeout )
+{
+    return sync_all_until( monotonic_time() + timeout );
+}
+
+TPool::sync_t
+TPool::sync_all_until ( const double  deadline )
+{
+    TScopedLock  lock( _idle_cond );
+
+    {
+        TScopedLock  work_lock( _work_mutex );
+
+        _sync_waiters++;
+    }
+    
+    bool  timeout = false;
+        
+    while ( true )
+    {
+        {
+            TScopedLock  work_lock( _work_mutex );
+
+            if (( _queue_size == 0 ) && ( _busy == 0 ))
+            {
+                _sync_waiters--;
+                return SYNC_FINISHED;
+            }// if
+
+            if ( timeout )
+            {
+                _sync_waiters--;
+                return SYNC_TIMEOUT;
+            }// if
+        }
+
+        // wait until all jobs have finished
+        timeout = ! _idle_cond.wait_until( deadline );
+    }// while
+}
+
+//
+// execute function by all threads
+//
+bool
+TPool::run_on_all ( spmd_func_t  f,
+                    void *       arg )
+{
+    if ( f == NULL )
+        return false;
+
+    // number of threads is fixed until finished
+    TScopedLock         resize_lock( _resize_mutex );
+    const unsigned int  n = _max_parallel;
+
+    if ( _sequential || ( n == 0 ))
+    {
+        f( 0, 1, arg );
+        return true;
+    }// if
+
+    TBarrier   spmd_barrier( n );
+    TJobGroup  group;
+
+    atomic_store( _spmd_barrier, & spmd_barrier );
+
+    // wake threads parked by auto-tuning
+    {
+        TScopedLock  lock( _spare_cond );
+
+        _spare_cond.broadcast();
+    }
+    
+    //
+    // jobs only finish after all have started if "barrier" is called, so
+    // each job is executed by a different thread (saturation is ignored)
+    //
+
+    for ( unsigned int  i = 0; i < n; i++ )
+    {
+        TJob *  job = new TSPMDJob( f, i, n );
+
+        job->set_group( & group );
+        job->lock();
+
+        // shutdown holds _resize_mutex until finished, so only the first
+        // push may fail (pool already shut down)
+        if ( push( job, arg, true, UINT_MAX ) != PUSH_OK )
+        {
+            reject( job, PUSH_CLOSED, "run_on_all" );
+            delete job;
+            atomic_store< TBarrier * >( _spmd_barrier, NULL );
+            
+            return false;
+        }// if
+    }// for
+
+    sync( group );
+    atomic_store< TBarrier * >( _spmd_barrier, NULL );
+
+    return true;
+}
+
+//
+// cancel job
+//
+void
+TPool::cancel ( TJob * job )
+{
+    if ( job == NULL )
+        return;
+
+    job->cancel();
+    purge( is_job, job );
+}
+
+//
+// cancel all jobs in group
+//
+void
+TPool::cancel ( TJobGroup & group )
+{
+    group.cancel();
+    purge( in_group, & group );
+}
+
+///////////////////////////////////////////////
+//
+// delayed and periodic jobs
+//
+
+TTimerId
+TPool::run_after ( const double  delay,
+                   TJob *        job,
+                   void *        ptr,
+                   const bool    del )
+{
+    if ( job == NULL )
+        return TTimerId();
+
+    // lock job for synchronisation; cancellation is only reset here, not
+    // when the timer enqueues the job, to keep "cancel" of a pending job
+    job->lock();
+    atomic_store( job->_cancelled, 0 );
+
+    if ( delay <= 0.0 )
+    {
+        enqueue( job, ptr, del );
+        return TTimerId();
+    }// if
+
+    {
+        // keep lock as wheel is deleted during shutdown
+        TScopedLock    lock( _timer_mutex );
+        TTimerWheel *  wheel = timers();
+
+        if ( wheel != NULL )
+        {
+            // pending job counts for its group
+            if ( job->_group != NULL )
+                job->_group->add_job();
+            
+            return wheel->add( delay, 0.0, job, ptr, del );
+        }// if
+    }
+    
+    enqueue( job, ptr, del );  // drops job after shutdown
+    
+    return TTimerId();
+}
+
+TTimerId
+TPool::run_every ( const double  period,
+                   TJob *        job,
+                   void *        ptr )
+{
+    if (( job == NULL ) || ( period <= 0.0 ))
+        return TTimerId();
+
+    atomic_store( job->_cancelled, 0 );
+
+    // keep lock as wheel is deleted during shutdown
+    TScopedLock    lock( _timer_mutex );
+    TTimerWheel *  wheel = timers();
+
+    if ( wheel == NULL )
+        return TTimerId();
+    
+    return wheel->add( period, period, job, ptr, false );
+}
+
+bool
+TPool::cancel_timer ( const TTimerId  id )
+{
+    // keep lock as wheel is deleted during shutdown
+    TScopedLock  lock( _timer_mutex );
+
+    if (( _timers == NULL ) || ! id.is_valid() )
+        return false;
+
+    return _timers->cancel( id );
+}
+
+///////////////////////////////////////////////
+//
+// manage job queue
+//
+
+//
+// append locked job to queue unless full or closed
+//
+TPool::push_t
+TPool::push ( TJob *              job,
+              void *              ptr,
+              const bool          del,
+              const unsigned int  limit,
+              const bool          retry )
+{
+    bool  start_thread = false;
+    
+    job->_pool_next       = NULL;
+    job->_pool_arg        = ptr;
+    job->_pool_del        = del;
+    job->_pool_completion = completion_for( job );
+
+    {
+        TScopedLock  lock( _work_mutex );
+
+        //
+        // during shutdown, jobs are only accepted as long as threads
+        // are executing jobs (and will look at the queue again)
+        //
+    
+        if ( _down || ( _end && ( _busy == 0 )))
+            return PUSH_CLOSED;
+
+        if ( _queue_size >= limit )
+        {
+            if ( ! retry )
+                _stats.queue_full++;
+        
+            return PUSH_FULL;
+        }// if
+    
+        queue_append( job );
+        _stats.submitted++;
+
+        if ( job->_group != NULL )
+            job->_group->add_job();
+
+        if ( _queue_size > _stats.max_queue_size )
+            _stats.max_queue_size = _queue_size;
+
+        // start new thread if not enough threads are idle
+        start_thread = (( _startup == STARTUP_LAZY ) &&
+                        ( _started < _max_parallel ) &&
+                        ( _started - _busy < _queue_size ));
+    }
+
+    if ( start_thread )
+        spawn();
+
+    //
+    // wake a blocked thread unless some thread is spinning and will
+    // take the job (no system call if no thread is blocked)
+    //
+
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    
+    if ( atomic_load( _spinning ) == 0 )
+        _work_event.notify_one();
+    
+    return PUSH_OK;
+}
+
+//
+// append locked job to queue, wait for space if full
+//
+TPool::push_t
+TPool::push_wait ( TJob *        job,
+                   void *        ptr,
+                   const bool    del,
+                   const bool    saturation,
+                   const double  deadline )
+{
+    push_t       res;
+    TScopedLock  lock( _space_cond );
+
+    {
+        TScopedLock  work_lock( _work_mutex );
+
+        _submitters++;
+    }
+                    
+    while (( res = push( job, ptr, del, queue_limit( saturation ), true ) ) == PUSH_FULL )
+    {
+        if ( deadline < 0.0 )
+            _space_cond.wait();
+        else if ( ! _space_cond.wait_until( deadline ) )
+        {
+            // last try after timeout
+            res = push( job, ptr, del, queue_limit( saturation ), true );
+            break;
+        }// if
+    }// while
+
+    {
+        TScopedLock  work_lock( _work_mutex );
+
+        _submitters--;
+    }
+
+    return res;
+}
+
+//
+// return maximal queue length for submission
+//
+unsigned int
+TPool::queue_limit ( const bool  saturation ) const
+{
+    unsigned int  limit = ( _capacity == 0 ? UINT_MAX : _capacity );
+
+    if ( saturation && ( _max_queued != 0 ) && ( _max_queued < limit ))
+        limit = _max_queued;
+
+    return limit;
+}
+
+//
+// release job not accepted by queue
+//
+bool
+TPool::reject ( TJob *        job,
+                const push_t  res,
+                const char *  func )
+{
+    if ( res == PUSH_CLOSED )
+        std::cerr << "(TPool) " << func << " : pool was shut down, job rejected" << std::endl;
+
+    job->unlock();
+
+    TScopedLock  lock( _work_mutex );
+
+    _stats.rejected++;
+
+    return false;
+}
+
+//
+// append locked job to queue (ignoring saturation)
+//
+void
+TPool::enqueue ( TJob *      job,
+                 void *      ptr,
+                 const bool  del )
+{
+    if ( push( job, ptr, del, UINT_MAX ) == PUSH_CLOSED )
+    {
+        std::cerr << "(TPool) enqueue : pool was shut down, job dropped" << std::endl;
+        drop( job );
+
+        TScopedLock  lock( _work_mutex );
+
+        _stats.dropped++;
+    }// if
+}
+
+//
+// append due delayed job to queue
+//
+void
+TPool::enqueue_delayed ( TJob *      job,
+                         void *      ptr,
+                         const bool  del )
+{
+    // job may be finished (and deleted) after "enqueue"
+    TJobGroup *  group = job->_group;
+
+    enqueue( job, ptr, del );
+
+    // group now accounts for queued job (or job was dropped)
+    if ( group != NULL )
+        group->finish_job();
+}
+
+//
+// release pending delayed job without execution
+//
+void
+TPool::drop_delayed ( TJob *      job,
+                      const bool  del )
+{
+    TJobGroup *  group = job->_group;
+
+    job->_pool_del        = del;
+    job->_pool_completion = completion_for( job );
+    drop( job );
+
+    if ( group != NULL )
+        group->finish_job();
+
+    TScopedLock  lock( _work_mutex );
+
+    _stats.dropped++;
+}
+
+//
+// execute locked job in calling thread
+//
+void
+TPool::run_inline ( TJob *      job,
+                    void *      ptr,
+                    const bool  del )
+{
+    job->_pool_completion = completion_for( job );
+    
+    job->run( ptr );
+    finish( job, del );
+}
+
+//
+// append job to FIFO or deadline queue
+//
+void
+TPool::queue_append ( TJob *  job )
+{
+    job->_pool_seq = _queue_seq++;
+    
+    if (( _schedule == SCHEDULE_EDF ) && ( job->_deadline > 0.0 ))
+    {
+        _deadline_queue.push_back( job );
+        std::push_heap( _deadline_queue.begin(), _deadline_queue.end(), later_deadline );
+    }// if
+    else if ( _schedule == SCHEDULE_FAIR )
+    {
+        TTenant &  tenant = _tenants[ job->_tenant < _tenants.size() ? job->_tenant : 0 ];
+
+        if ( tenant.tail == NULL )
+            tenant.head = job;
+        else
+            tenant.tail->_pool_next = job;
+
+        tenant.tail     = job;
+        job->_pool_time = monotonic_time();
+        tenant.stats.submitted++;
+        tenant.stats.queued++;
+        _tenant_jobs++;
+    }// if
+    else
+    {
+        if ( _queue_tail == NULL )
+            _queue_head = job;
+        else
+            _queue_tail->_pool_next = job;
+
+        _queue_tail = job;
+    }// else
+    
+    _queue_size++;
+}
+
+//
+// remove next job from queues (jobs with deadline first)
+//
+TPool::TJob *
+TPool::queue_pop ()
+{
+    TJob *  job = NULL;
+    
+    if ( ! _deadline_queue.empty() )
+    {
+        std::pop_heap( _deadline_queue.begin(), _deadline_queue.end(), later_deadline );
+        job = _deadline_queue.back();
+        _deadline_queue.pop_back();
+    }// if
+    else if ( _tenant_jobs > 0 )
+    {
+        //
+        // deficit round robin: the current tenant starts jobs until its
+        // deficit is used up, the next non-empty tenant gets its weight
+        //
+        
+        while (( _tenants[ _tenant_cursor ].head == NULL ) ||
+               ( _tenants[ _tenant_cursor ].deficit == 0 ))
+        {
+            _tenant_cursor = ( _tenant_cursor + 1 ) % _tenants.size();
+
+            TTenant &  next = _tenants[ _tenant_cursor ];
+            
+            if ( next.head != NULL )
+                next.deficit += next.weight;
+        }// while
+
+        TTenant &  tenant = _tenants[ _tenant_cursor ];
+        
+        job         = tenant.head;
+        tenant.head = job->_pool_next;
+    
+        if ( tenant.head == NULL )
+        {
+            // empty tenants keep no deficit
+            tenant.tail    = NULL;
+            tenant.deficit = 0;
+        }// if
+        else
+            tenant.deficit--;
+
+        tenant.stats.started++;
+        tenant.stats.queued--;
+        tenant.stats.wait_time += monotonic_time() - job->_pool_time;
+        _tenant_jobs--;
+    }// if
+    else
+    {
+        job = _queue_head;
+
+        _queue_head = job->_pool_next;
+    
+        if ( _queue_head == NULL )
+            _queue_tail = NULL;
+    }// else
+    
+    job->_pool_next = NULL;
+    _queue_size--;
+
+    return job;
+}
+
+//
+// remove matching jobs from list
+//
+unsigned int
+TPool::purge_list ( TJob *&        head,
+                    TJob *&        tail,
+                    bool (* pred) ( const TJob *, const void * ),
+                    const void *   arg,
+                    TJob *&        dropped )
+{
+    TJob *        prev = NULL;
+    TJob *        job  = head;
+    unsigned int  n    = 0;
+
+    while ( job != NULL )
+    {
+        TJob *  next = job->_pool_next;
+            
+        if ( pred( job, arg ) )
+        {
+            // unlink job and remember for release
+            if ( prev == NULL ) head             = next;
+            else                prev->_pool_next = next;
+
+            if ( tail == job )
+                tail = prev;
+
+            job->_pool_next = dropped;
+            dropped         = job;
+            n++;
+        }// if
+        else
+            prev = job;
+
+        job = next;
+    }// while
+
+    return n;
+}
+
+//
+// order of jobs in deadline queue (heap with earliest deadline on top)
+//
+bool
+TPool::later_deadline ( const TJob *  a,
+                        const TJob *  b )
+{
+    if ( a->_deadline != b->_deadline )
+        return a->_deadline > b->_deadline;
+
+    return a->_pool_seq > b->_pool_seq;
+}
+
+//
+// account for finished job and return next job from queue (wait if empty)
+//
+TPool::TJob *
+TPool::dequeue ( const unsigned int  thr_no,
+                 const bool          done,
+                 const bool          executed,
+                 const bool          missed,
+                 bool &              token )
+{
+    bool  account   = done;
+    bool  from_spin = false;
+    
+    while ( true )
+    {
+        TJob *  job            = NULL;
+        bool    wake_sync      = false;
+        bool    wake_submitter = false;
+        bool    more_jobs      = false;
+        bool    end            = false;
+        bool    park           = false;
+        bool    throttled      = false;
+        bool    wake_parked    = false;
+        double  now            = 0.0;
+
+        // time for auto-tuning (read outside of lock)
+        if ( _tune )
+            now = monotonic_time();
+    
+        {
+            TScopedLock  lock( _work_mutex );
+
+            // account for previous job
+            if ( account )
+            {
+                if ( executed ) _stats.executed++;
+                else            _stats.dropped++;
+
+                if ( missed )
+                    _stats.deadline_misses++;
+        
+                _busy--;
+                account   = false;
+
+                // return token of budget if needed by other threads
+                if ( token && _budget->contended() && _budget->must_yield( _budget_id ) )
+                {
+                    _budget->release( _budget_id );
+                    token = false;
+                }// if
+
+                wake_sync = (( _busy == 0 ) && ( _queue_size == 0 ) && ( _sync_waiters > 0 ));
+            }// if
+            
+            // adjust number of active threads
+            if ( _tune && ( now >= _tune_next ))
+                wake_parked = tune( now );
+            
+            // thread was removed by "resize", is a spare thread not needed
+            // or was parked by auto-tuning (pass on wakeup for queued jobs)
+            if ( retired( thr_no ) )
+            {
+                end       = exiting( thr_no );
+                park      = ! end;
+                more_jobs = ( _queue_size > 0 );
+            }// if
+            else if (( _queue_size > 0 ) && ( _budget != NULL ) && ( _spmd_barrier == NULL ) &&
+                     ! token && ! ( token = _budget->try_acquire( _budget_id )))
+            {
+                // no token available: wait for other threads
+                throttled = true;
+                _stats.throttled++;
+            }// if
+            else if ( _queue_size > 0 )
+            {
+                job = queue_pop();
+                _busy++;
+
+                if ( job->_deadline > 0.0 )
+                    _stats.deadline_jobs++;
+                
+                wake_submitter = ( _submitters > 0 );
+                more_jobs      = ( _queue_size > 0 );
+            }// if
 
+            // return token taken while waiting if no job is left
+            if (( job == NULL ) && token )
             {
-                TScopedLock  work_lock( _work_cond );
+                _budget->release( _budget_id );
+                token = false;
+            }// if
             
-                while (( _job == NULL ) && ! _end )
-                    _work_cond.wait();
-            }
+            end = end || _end;
+        }
+
+        // wake threads waiting in sync_all
+        if ( wake_sync )
+        {
+            TScopedLock  lock( _idle_cond );
         
-            //
-            // look if we really have a job to do
-            // and handle it
-            //
+            _idle_cond.broadcast();
+        }// if
+
+        // wake threads activated by auto-tuning
+        if ( wake_parked )
+        {
+            TScopedLock  lock( _spare_cond );
 
-            if ( _job != NULL )
+            _spare_cond.broadcast();
+        }// if
+        
+        if ( job != NULL )
+        {
+            // wake thread waiting for space in queue
+            if ( wake_submitter )
             {
-                // execute job
-                _job->run( _data_ptr );
-                _job->unlock();
+                TScopedLock  lock( _space_cond );
+
+                _space_cond.signal();
+            }// if
+
+            // a spinning thread was not woken by "push": hand over
+            // remaining jobs to a blocked thread
+            if ( from_spin && more_jobs )
+                _work_event.notify_one();
+            
+            return job;
+        }// if
+
+        if ( end )
+        {
+            if ( more_jobs )
+                _work_event.notify_one();
+            
+            return NULL;
+        }// if
+
+        //
+        // wait for token of budget
+        //
+
+        if ( throttled )
+        {
+            TScopedLock  lock( _budget->_cond );
+
+            _budget->add_waiter( _budget_id );
             
-                if ( _del_job )
-                    delete _job;
+            while ( ! _budget->available( _budget_id ) && ! atomic_load( _end ) && ! retired( thr_no ) )
+                _budget->_cond.wait();
 
-                // reset data
-                TScopedLock  work_lock( _work_cond );
+            _budget->remove_waiter( _budget_id );
 
-                _job      = NULL;
-                _data_ptr = NULL;
+            // take token at once to not lose it to other pools
+            if ( _budget->available( _budget_id ) )
+            {
+                _budget->take( _budget_id );
+                token = true;
             }// if
-        }// while
-    }
 
-    //
-    // set and run job with optional data
-    //
-    void run_job  ( TPool::TJob * j, void * p, const bool del = false )
-    {
-        TScopedLock  lock( _work_cond );
-        
-        _job      = j;
-        _data_ptr = p;
-        _del_job  = del;
+            continue;
+        }// if
         
-        _work_cond.signal();
-    }
+        //
+        // park thread until needed again (or finished)
+        //
 
-    //
-    // give access to delete mutex
-    //
-    
-    TMutex & del_mutex  ()
-    {
-        return _del_mutex;
-    }
+        if ( park )
+        {
+            if ( more_jobs )
+                _work_event.notify_one();
 
-    //
-    // quit thread (reset data and wake up)
-    //
-    
-    void quit ()
-    {
-        TScopedLock  lock( _work_cond );
-        
-        _end      = true;
-        _job      = NULL;
-        _data_ptr = NULL;
-        
-        _work_cond.signal();
-    }
-};
-    
-//////////////////////////////////////////////////////////////////////////
-//////////////////////////////////////////////////////////////////////////
-//
-// ThreadPool - implementation
-//
-//////////////////////////////////////////////////////////////////////////
-//////////////////////////////////////////////////////////////////////////
+            TScopedLock  lock( _spare_cond );
 
-//
-// constructor and destructor
-//
+            while ( retired( thr_no ) && ! exiting( thr_no ) )
+                _spare_cond.wait();
 
-TPool::TPool ( const unsigned int  max_p )
-{
-    //
-    // create max_p threads for pool
-    //
+            continue;
+        }// if
 
-    _max_parallel = max_p;
+        //
+        // wait for new jobs: spin or yield first (if requested), then block
+        //
 
-    _threads = new TPoolThr*[ _max_parallel ];
+        from_spin = false;
 
-    if ( _threads == NULL )
-    {
-        _max_parallel = 0;
-        std::cerr << "(TPool) TPool : could not allocate thread array" << std::endl;
-    }// if
-    
-    for ( unsigned int  i = 0; i < _max_parallel; i++ )
-    {
-        _threads[i] = new TPoolThr( i, this );
+        // no spinning on a single processor (even with WAIT_BUSY)
+        const bool  spin = (( _wait != WAIT_PARK ) && may_spin() );
+        
+        if ( spin )
+        {
+            atomic_add( _spinning, 1 );
 
-        if ( _threads == NULL )
-            std::cerr << "(TPool) TPool : could not allocate thread" << std::endl;
-        else
-            _threads[i]->create( true, true );
-    }// for
+            if ( spin_wait( thr_no ) )
+            {
+                atomic_add( _spinning, -1 );
+                from_spin = true;
+                continue;
+            }// if
+        }// if
 
-    // tell the scheduling system, how many threads to expect
-    // (commented out since not needed on most systems)
-//     if ( pthread_setconcurrency( _max_parallel + pthread_getconcurrency() ) != 0 )
-//         std::cerr << "(TPool) TPool : pthread_setconcurrency ("
-//                   << strerror( status ) << ")" << std::endl;
+        const int  key = _work_event.prepare_wait();
+
+        if ( spin )
+            atomic_add( _spinning, -1 );
+
+        // order against "push": queue size is written before "_spinning" is read
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+        
+        if (( atomic_load( _queue_size ) > 0 ) || atomic_load( _end ) || retired( thr_no ))
+            _work_event.cancel_wait();
+        else
+            _work_event.wait( key );
+    }// while
 }
 
-TPool::~TPool ()
+//
+// spin until job queue is not empty
+//
+bool
+TPool::spin_wait ( const unsigned int  thr_no ) const
 {
-    // wait till all threads have finished
-    sync_all();
+    const bool  busy = ( _wait == WAIT_BUSY );
     
-    // finish all thread
-    for ( unsigned int  i = 0; i < _max_parallel; i++ )
-        _threads[i]->quit();
-    
-    // cancel and delete all threads (not really safe !)
-    for ( unsigned int  i = 0; i < _max_parallel; i++ )
+    for ( unsigned int  i = 0; busy || ( i < _spins + _yields ); i++ )
     {
-        _threads[i]->del_mutex().lock();
-        delete _threads[i];
+        if (( atomic_load( _queue_size ) > 0 ) || atomic_load( _end ) || retired( thr_no ))
+            return true;
+
+        if ( busy || ( i < _spins ) )
+            cpu_relax();
+        else
+            sched_yield();
     }// for
 
-    delete[] _threads;
+    return false;
 }
 
-///////////////////////////////////////////////
 //
-// run, stop and synch with job
+// remove matching jobs from queue
 //
-
 void
-TPool::run ( TPool::TJob * job, void * ptr, const bool del )
+TPool::purge ( bool (* pred) ( const TJob *, const void * ),
+               const void *  arg )
 {
-    if ( job == NULL )
+    TJob *  dropped = NULL;
+    bool    all_done;
+    
+    {
+        TScopedLock  lock( _work_mutex );
+        TJob *       job  = NULL;
+        unsigned int n    = purge_list( _queue_head, _queue_tail, pred, arg, dropped );
+
+        _queue_size    -= n;
+        _stats.dropped += n;
+
+        for ( size_t  i = 0; i < _tenants.size(); i++ )
+        {
+            TTenant &  tenant = _tenants[i];
+
+            n = purge_list( tenant.head, tenant.tail, pred, arg, dropped );
+
+            if ( tenant.head == NULL )
+                tenant.deficit = 0;
+            
+            tenant.stats.dropped += n;
+            tenant.stats.queued  -= n;
+            _tenant_jobs         -= n;
+            _queue_size          -= n;
+            _stats.dropped       += n;
+        }// for
+        
+        // remove matching jobs from deadline queue and restore heap
+        size_t  kept = 0;
+
+        for ( size_t  i = 0; i < _deadline_queue.size(); i++ )
+        {
+            job = _deadline_queue[i];
+            
+            if ( pred( job, arg ) )
+            {
+                _queue_size--;
+                _stats.dropped++;
+                job->_pool_next = dropped;
+                dropped         = job;
+            }// if
+            else
+                _deadline_queue[ kept++ ] = job;
+        }// for
+
+        if ( kept < _deadline_queue.size() )
+        {
+            _deadline_queue.resize( kept );
+            std::make_heap( _deadline_queue.begin(), _deadline_queue.end(), later_deadline );
+        }// if
+
+        all_done = (( _busy == 0 ) && ( _queue_size == 0 ));
+    }
+
+    if ( dropped == NULL )
         return;
 
-#if THR_SEQUENTIAL == 1
-    //
-    // run in calling thread
-    //
-    
-    job->run( ptr );
+    // wake threads waiting for space in queue
+    {
+        TScopedLock  lock( _space_cond );
 
-    if ( del )
-        delete job;
+        _space_cond.broadcast();
+    }
     
-#else
-    //
-    // run in parallel thread
-    //
+    while ( dropped != NULL )
+    {
+        TJob *       next  = dropped->_pool_next;
+        TJobGroup *  group = dropped->group();
 
-    TPoolThr * thr = get_idle();
-    
-    // lock job for synchronisation
-    job->lock();
+        dropped->_pool_next = NULL;
+        drop( dropped );
+        
+        if ( group != NULL )
+            group->finish_job();
+        
+        dropped = next;
+    }// while
 
-    // attach job to thread
-    thr->run_job( job, ptr, del );
-#endif
+    // wake threads waiting in sync_all
+    if ( all_done )
+    {
+        TScopedLock  lock( _idle_cond );
+        
+        _idle_cond.broadcast();
+    }// if
 }
 
 //
-// wait until <job> was executed
+// release job without execution
 //
 void
-TPool::sync ( TJob * job )
+TPool::drop ( TJob * job )
 {
-    if ( job == NULL )
-        return;
-    
-    job->lock();
-    job->unlock();
+    finish( job, job->_pool_del );
 }
 
 //
-// wait until all jobs have been executed
+// release executed or dropped job
 //
 void
-TPool::sync_all ()
+TPool::finish ( TJob *      job,
+                const bool  del )
 {
-    while ( true )
-    {
-        {
-            TScopedLock  lock( _idle_cond );
-        
-            // wait until next thread becomes idle
-            if ( _idle_threads.size() < _max_parallel )
-                _idle_cond.wait();
-            else
-            {
-                break;
-            }// else
-        }
-    }// while
-}
+    TCompletionQueue *  cq = job->_pool_completion;
+    
+    job->unlock();
 
-///////////////////////////////////////////////
-//
-// manage pool threads
-//
+    if ( del )
+        delete job;
+    else if ( cq != NULL )
+        cq->push( job );
+}
 
 //
-// return idle thread form pool
+// return completion queue for job
 //
-TPoolThr *
-TPool::get_idle ()
+TCompletionQueue *
+TPool::completion_for ( const TJob *  job ) const
 {
-    while ( true )
-    {
-        //
-        // wait for an idle thread
-        //
-
-        TScopedLock  lock( _idle_cond );
-        
-        while ( _idle_threads.empty() )
-            _idle_cond.wait();
-
-        //
-        // get first idle thread
-        //
-        
-        if ( ! _idle_threads.empty() )
-        {
-            TPoolThr * t = _idle_threads.front();
+    if (( job->_group != NULL ) && ( job->_group->_completion != NULL ))
+        return job->_group->_completion;
 
-            _idle_threads.pop_front();
-            
-            return t;
-        }// if
-    }// while
+    return _completion;
 }
 
 //
-// append recently finished thread to idle list
+// return (and create) timer wheel; "_timer_mutex" has to be locked
 //
-void
-TPool::append_idle ( TPoolThr * t )
+TTimerWheel *
+TPool::timers ()
 {
-    //
-    // CONSISTENCY CHECK: if given thread is already in list
-    //
-    
-    TScopedLock  lock( _idle_cond );
-
-    for ( std::list< TPoolThr * >::iterator  iter = _idle_threads.begin();
-          iter != _idle_threads.end();
-          ++iter )
-    {
-        if ( (*iter) == t )
-        {
-            return;
-        }// if
-    }// while
-    
-    _idle_threads.push_back( t );
+    if (( _timers == NULL ) && ! _end )
+        _timers = new TTimerWheel( this );
 
-    // wake a blocked thread for job execution
-    _idle_cond.signal();
+    return _timers;
 }
 
 ///////////////////////////////////////////////////
@@ -365,25 +2360,54 @@ TPool::append_idle ( TPoolThr * t )
 // init global thread_pool
 //
 void
-init ( const unsigned int  max_p )
+init ( const unsigned int      max_p,
+       const TThreadAttr &     attr,
+       const TPool::startup_t  startup )
 {
     if ( thread_pool != NULL )
         delete thread_pool;
     
-    if ((thread_pool = new TPool( max_p )) == NULL)
+    if ((thread_pool = new TPool( max_p, attr, startup )) == NULL)
         std::cerr << "(init_thread_pool) could not allocate thread pool" << std::endl;
 }
 
 //
-// run job
+// change number of threads
 //
 void
+resize ( const unsigned int  max_p )
+{
+    thread_pool->resize( max_p );
+}
+
+//
+// run job
+//
+bool
 run ( TPool::TJob * job, void * ptr, const bool del )
 {
     if ( job == NULL )
-        return;
+        return false;
     
-    thread_pool->run( job, ptr, del );
+    return thread_pool->run( job, ptr, del );
+}
+
+//
+// run job if queue is not full
+//
+bool
+try_run ( TPool::TJob * job, void * ptr, const bool del )
+{
+    return thread_pool->try_run( job, ptr, del );
+}
+
+//
+// run job, wait for space in queue for given time
+//
+bool
+run_for ( TPool::TJob * job, const double timeout, void * ptr, const bool del )
+{
+    return thread_pool->run_for( job, timeout, ptr, del );
 }
 
 //
@@ -404,13 +2428,81 @@ sync_all ()
     thread_pool->sync_all();
 }
 
+//
+// timed synchronisation
+//
+TPool::sync_t
+sync_for ( TPool::TJob * job, const double timeout )
+{
+    return thread_pool->sync_for( job, timeout );
+}
+
+TPool::sync_t
+sync_for ( TPool::TJobGroup & group, const double timeout )
+{
+    return thread_pool->sync_for( group, timeout );
+}
+
+TPool::sync_t
+sync_all_for ( const double timeout )
+{
+    return thread_pool->sync_all_for( timeout );
+}
+
+//
+// cancel job or group
+//
+void
+cancel ( TPool::TJob * job )
+{
+    thread_pool->cancel( job );
+}
+
+void
+cancel ( TPool::TJobGroup & group )
+{
+    thread_pool->cancel( group );
+}
+
+//
+// delayed and periodic jobs
+//
+TTimerId
+run_after ( const double   delay,
+            TPool::TJob *  job,
+            void *         ptr,
+            const bool     del )
+{
+    return thread_pool->run_after( delay, job, ptr, del );
+}
+
+TTimerId
+run_every ( const double   period,
+            TPool::TJob *  job,
+            void *         ptr )
+{
+    return thread_pool->run_every( period, job, ptr );
+}
+
+bool
+cancel_timer ( const TTimerId  id )
+{
+    return thread_pool->cancel_timer( id );
+}
+
 //
 // finish thread pool
 //
 void
-done ()
+done ( const TPool::shutdown_t  mode )
 {
+    if ( thread_pool == NULL )
+        return;
+    
+    thread_pool->shutdown( mode );
+    
     delete thread_pool;
+    thread_pool = NULL;
 }
 
 }// namespace ThreadPool
@@ -8,9 +8,13 @@
 //
 
 #include <iostream>
-#include <list>
+#include <vector>
+#include <climits>
 
 #include "TThread.hh"
+#include "TAtomic.hh"
+#include "TSync.hh"
+#include "TArena.hh"
 
 namespace ThreadPool
 {
@@ -18,8 +22,33 @@ namespace ThreadPool
 // no specific processor
 const int  NO_PROC = -1;
 
-// forward decl. for internal class
+// forward decl. for internal classes
 class TPoolThr;
+class TTimerWheel;
+class TStrand;
+class TThreadBudget;
+class TCompletionQueue;
+
+//!
+//! \class  TTimerId
+//! \brief  handle of a delayed or periodic job (see TPool::run_after)
+//!
+struct TTimerId
+{
+    //! slot of timer in timer wheel
+    unsigned int  slot;
+
+    //! generation of slot to detect reused slots (0: invalid handle)
+    unsigned int  gen;
+
+    TTimerId ( const unsigned int  s = 0,
+               const unsigned int  g = 0 )
+            : slot(s), gen(g)
+    {}
+
+    //! return true if handle refers to a timer
+    bool  is_valid () const { return gen != 0; }
+};
 
 //!
 //! \class  TPool
@@ -29,8 +58,280 @@ class TPoolThr;
 class TPool
 {
     friend class TPoolThr;
+    friend class TTimerWheel;
+    friend class TBlockingRegion;
+    friend class TStrand;
     
 public:
+    //! number of threads to choose pool size by available processors
+    //! (see available_cpus)
+    static const unsigned int  AUTO_SIZE = 0;
+
+    //! function returning data of worker-local slot for thread \a thr_no
+    typedef void * (* slot_init_t) ( const unsigned int  thr_no,
+                                     void *              arg );
+
+    //! function releasing \a data of worker-local slot
+    typedef void   (* slot_done_t) ( void *  data,
+                                     void *  arg );
+
+    //! function executed by all threads in "run_on_all" with rank
+    //! \a thr_no of \a nthreads
+    typedef void   (* spmd_func_t) ( const unsigned int  thr_no,
+                                     const unsigned int  nthreads,
+                                     void *              arg );
+    
+    //! modes for shutting down the pool
+    enum shutdown_t
+    {
+        SHUTDOWN_DRAIN,      //!< finish all queued jobs
+        SHUTDOWN_DISCARD     //!< drop queued jobs without execution
+    };
+    
+    //! result of timed synchronisation
+    enum sync_t
+    {
+        SYNC_FINISHED,       //!< all jobs have finished
+        SYNC_TIMEOUT         //!< deadline was reached before
+    };
+    
+    //! modes for starting the threads of the pool
+    enum startup_t
+    {
+        STARTUP_EAGER,       //!< start all threads in constructor
+        STARTUP_PARALLEL,    //!< start first thread, which (recursively)
+                             //!< starts the remaining threads
+        STARTUP_LAZY         //!< start threads on demand, e.g. if more jobs
+                             //!< are queued than threads are idle
+    };
+    
+    //! strategies of idle threads waiting for jobs (and of "sync")
+    enum wait_t
+    {
+        WAIT_PARK,           //!< block immediately
+        WAIT_ADAPTIVE,       //!< spin, then yield processor, then block
+        WAIT_BUSY            //!< spin forever, e.g. for dedicated cores
+    };
+    
+    //! policies for "run" if the job queue is saturated
+    enum saturation_t
+    {
+        SATURATION_BLOCK,       //!< wait until queue has space again
+        SATURATION_REJECT,      //!< return without accepting job
+        SATURATION_CALLER_RUNS  //!< execute job in calling thread
+    };
+    
+    //! order in which queued jobs are executed
+    enum schedule_t
+    {
+        SCHEDULE_FIFO,          //!< in order of submission
+        SCHEDULE_EDF,           //!< earliest deadline first, jobs without
+                                //!< deadline in order of submission after
+                                //!< all jobs with deadline
+        SCHEDULE_FAIR           //!< jobs of tenants (see add_tenant) by
+                                //!< weighted round robin
+    };
+    
+    ///////////////////////////////////////////
+    //!
+    //! \struct TStats
+    //! \brief  statistics of the pool
+    //!
+
+    struct TStats
+    {
+        //! number of jobs accepted by the pool (queued or executed inline)
+        unsigned long  submitted;
+
+        //! number of jobs executed by threads of the pool
+        unsigned long  executed;
+
+        //! number of jobs executed in the calling thread due to saturation
+        unsigned long  caller_runs;
+
+        //! number of jobs rejected due to saturation or shutdown
+        unsigned long  rejected;
+
+        //! number of jobs released without execution (cancellation or shutdown)
+        unsigned long  dropped;
+
+        //! number of submissions finding the job queue full
+        unsigned long  queue_full;
+
+        //! maximal length of job queue
+        unsigned int   max_queue_size;
+
+        //! number of jobs with deadline started by threads of the pool
+        unsigned long  deadline_jobs;
+
+        //! number of executed jobs finished after their deadline
+        unsigned long  deadline_misses;
+
+        //! number of blocking regions entered by jobs
+        unsigned long  blocking_regions;
+
+        //! number of times a thread waited for a token of the thread budget
+        unsigned long  throttled;
+
+        //! number of increases and decreases of the number of active
+        //! threads by auto-tuning (see set_auto_tune)
+        unsigned long  tune_increases;
+        unsigned long  tune_decreases;
+
+        //! number of active threads (max_parallel without auto-tuning)
+        unsigned int   active_limit;
+
+        TStats ()
+                : submitted(0), executed(0), caller_runs(0), rejected(0),
+                  dropped(0), queue_full(0), max_queue_size(0),
+                  deadline_jobs(0), deadline_misses(0), blocking_regions(0),
+                  throttled(0), tune_increases(0), tune_decreases(0), active_limit(0)
+        {}
+    };
+    
+    ///////////////////////////////////////////
+    //!
+    //! \struct TTenantStats
+    //! \brief  statistics of a tenant (with SCHEDULE_FAIR)
+    //!
+
+    struct TTenantStats
+    {
+        //! number of jobs queued for tenant
+        unsigned long  submitted;
+
+        //! number of jobs started by threads of the pool
+        unsigned long  started;
+
+        //! number of jobs released without execution
+        unsigned long  dropped;
+
+        //! number of currently queued jobs
+        unsigned int   queued;
+
+        //! accumulated time of started jobs in queue (in seconds)
+        double         wait_time;
+
+        TTenantStats ()
+                : submitted(0), started(0), dropped(0), queued(0), wait_time(0.0)
+        {}
+    };
+    
+    ///////////////////////////////////////////
+    //!
+    //! \class  TBlockingRegion
+    //! \brief  scope of a job in which the calling thread may block, e.g.
+    //!         for I/O; meanwhile the pool executes jobs with a spare thread
+    //!         (see set_max_spare), which is parked again after the region
+    //!         (no effect if not called by a thread of a pool)
+    //!
+
+    class TBlockingRegion
+    {
+    protected:
+        // @cond
+
+        // pool of calling thread
+        TPool *  _pool;
+
+        // indicates token of thread budget returned during region
+        bool     _token;
+
+        // prevent copy operations
+        TBlockingRegion ( const TBlockingRegion & );
+        TBlockingRegion & operator = ( const TBlockingRegion & );
+        
+        // @endcond
+
+    public:
+        //! enter blocking region
+        TBlockingRegion ();
+
+        //! leave blocking region
+        ~TBlockingRegion ();
+    };
+    
+    ///////////////////////////////////////////
+    //!
+    //! \class  TJobGroup
+    //! \brief  group of jobs sharing a cancellation flag
+    //!
+
+    class TJobGroup
+    {
+        friend class TPool;
+        friend class TPoolThr;
+        friend class TStrand;
+        
+    protected:
+        // @cond
+
+        // cancellation flag
+        volatile int  _cancelled;
+
+        // number of queued and running jobs in group
+        unsigned int  _pending;
+
+        // condition for synchronisation with jobs (guards _pending)
+        TCondition    _sync_cond;
+
+        // completion queue for finished jobs of group (optional)
+        TCompletionQueue *  _completion;
+        
+        // @endcond
+
+    public:
+        //! construct (not cancelled) job group
+        TJobGroup () : _cancelled(0), _pending(0), _completion(NULL) {}
+
+        //! report finished jobs of group to \a cq (overrides completion
+        //! queue of pool; only affects jobs submitted afterwards)
+        void set_completion_queue ( TCompletionQueue *  cq ) { _completion = cq; }
+
+        //! return completion queue of group (or NULL)
+        TCompletionQueue * completion_queue () const { return _completion; }
+
+        //! request cancellation of all jobs in group (see TPool::cancel to
+        //! also remove queued jobs immediately)
+        void cancel       () { atomic_store( _cancelled, 1 ); }
+
+        //! reset cancellation flag, e.g. to reuse group
+        void reset        () { atomic_store( _cancelled, 0 ); }
+
+        //! return true if cancellation was requested
+        bool is_cancelled () const { return atomic_load( _cancelled ) != 0; }
+
+        //! return number of queued and running jobs in group
+        unsigned int  pending ()
+        {
+            TScopedLock  lock( _sync_cond );
+
+            return _pending;
+        }
+        
+    protected:
+        // @cond
+
+        // account for job appended to the queue of a pool
+        void  add_job ()
+        {
+            TScopedLock  lock( _sync_cond );
+
+            _pending++;
+        }
+
+        // account for finished (or dropped) job and wake waiting threads
+        void  finish_job ()
+        {
+            TScopedLock  lock( _sync_cond );
+
+            if ( --_pending == 0 )
+                _sync_cond.broadcast();
+        }
+        
+        // @endcond
+    };
+    
     ///////////////////////////////////////////
     //!
     //! \class  TJob
@@ -39,6 +340,11 @@ public:
 
     class TJob
     {
+        friend class TPool;
+        friend class TPoolThr;
+        friend class TStrand;
+        friend class TCompletionQueue;
+        
     protected:
         // @cond
         
@@ -47,6 +353,32 @@ public:
 
         // mutex for synchronisation
         TMutex     _sync_mutex;
+
+        // group of job (optional) and cancellation flag of job
+        TJobGroup *   _group;
+        volatile int  _cancelled;
+
+        // next job in queue of pool
+        TJob *     _pool_next;
+
+        // argument for "run" and deletion flag as given to pool
+        void *     _pool_arg;
+        bool       _pool_del;
+
+        // absolute deadline (monotonic time, 0: none) and submission
+        // number for ordering jobs with equal deadline
+        double          _deadline;
+        unsigned long   _pool_seq;
+
+        // tenant of job and time of submission (with SCHEDULE_FAIR)
+        unsigned int    _tenant;
+        double          _pool_time;
+
+        // completion queue receiving job after execution, next job in
+        // completion queue and indicates job in completion queue
+        TCompletionQueue *  _pool_completion;
+        TJob *              _completion_next;
+        volatile int        _completion_queued;
         
         // @endcond
         
@@ -55,7 +387,10 @@ public:
         //! construct job object with \a n as job number
         //!
         TJob ( const int  n = NO_PROC )
-                : _job_no(n)
+                : _job_no(n), _group(NULL), _cancelled(0),
+                  _pool_next(NULL), _pool_arg(NULL), _pool_del(false),
+                  _deadline(0.0), _pool_seq(0), _tenant(0), _pool_time(0.0),
+                  _pool_completion(NULL), _completion_next(NULL), _completion_queued(0)
         {}
 
         //!
@@ -81,6 +416,41 @@ public:
         //! unlock internal mutex
         void unlock () { _sync_mutex.unlock(); }
 
+        //! try to lock internal mutex, return true on success
+        bool try_lock () { return _sync_mutex.try_lock(); }
+
+        //! set group of job (\a g may be NULL)
+        void set_group ( TJobGroup *  g ) { _group = g; }
+
+        //! return group of job
+        TJobGroup * group () const { return _group; }
+
+        //! set absolute deadline \a t of job (see monotonic_time; 0: no
+        //! deadline), used for scheduling with SCHEDULE_EDF and counting
+        //! deadline misses
+        void   set_deadline ( const double  t ) { _deadline = t; }
+
+        //! return deadline of job (0: no deadline)
+        double deadline     () const { return _deadline; }
+
+        //! set tenant \a id of job (see TPool::add_tenant; default: 0)
+        void         set_tenant ( const unsigned int  id ) { _tenant = id; }
+
+        //! return tenant of job
+        unsigned int tenant     () const { return _tenant; }
+
+        //! request cancellation of job: a queued job will be dropped without
+        //! execution, a running job may poll "is_cancelled" to finish early
+        //! (flag is reset when job is given to the pool)
+        void cancel () { atomic_store( _cancelled, 1 ); }
+
+        //! return true if cancellation of job or of its group was requested
+        bool is_cancelled () const
+        {
+            return (( atomic_load( _cancelled ) != 0 ) ||
+                    (( _group != NULL ) && _group->is_cancelled() ));
+        }
+
         //! return true if if proc-no \a p is local one
         bool on_proc ( const int  p ) const
         {
@@ -90,19 +460,210 @@ public:
     
 protected:
     // @cond
+
+    //
+    // data is grouped by access pattern and groups are separated by
+    // padding to avoid false sharing between submitting and working threads:
+    //   - read-mostly configuration
+    //   - job queue (written by submitting and working threads under lock)
+    //   - state of idle threads (written by idle threads without lock)
+    //   - rarely used data for management of threads, timers, etc.
+    //
+    
+    //
+    // read-mostly configuration
+    //
     
     // maximum degree of parallelism
     unsigned int             _max_parallel;
 
-    // array of threads, handled by pool
-    TPoolThr **              _threads;
+    // number of started threads (including threads being created)
+    volatile unsigned int    _started;
+
+    // mode for starting threads
+    startup_t                _startup;
+
+    // policy and queue length for saturated pool (0: unlimited)
+    saturation_t             _saturation;
+    unsigned int             _max_queued;
+
+    // maximal number of queued jobs (0: unlimited)
+    unsigned int             _capacity;
+
+    // order of execution of queued jobs
+    schedule_t               _schedule;
+
+    // execute all jobs in calling thread
+    bool                     _sequential;
+
+    // wait strategy and number of spin and yield rounds before blocking
+    wait_t                   _wait;
+    unsigned int             _spins;
+    unsigned int             _yields;
+
+    // minimal chunk size and huge page backing of arenas of threads
+    size_t                   _arena_size;
+    bool                     _arena_huge;
+
+    // maximal number of spare threads for blocking regions
+    unsigned int             _max_spare;
+
+    // budget of active threads shared with other pools and id of pool
+    TThreadBudget *          _budget;
+    unsigned int             _budget_id;
+
+    // completion queue for finished jobs (optional)
+    TCompletionQueue *       _completion;
+
+    // auto-tuning of number of active threads: bounds and interval between
+    // adjustments (seconds)
+    bool                     _tune;
+    unsigned int             _tune_min, _tune_max;
+    double                   _tune_interval;
+
+    char                     _pad_config[ CACHE_LINE_SIZE ];
+    
+    //
+    // job queue
+    //
+    
+    // mutex for synchronisation of job queue (guards data below)
+    TMutex                   _work_mutex;
+
+    // queue of jobs waiting for execution (FIFO)
+    TJob *                   _queue_head;
+    TJob *                   _queue_tail;
+
+    // heap of jobs with deadline for SCHEDULE_EDF (earliest first)
+    std::vector< TJob * >    _deadline_queue;
+
+    // queues of tenants for SCHEDULE_FAIR with weight and deficit
+    // (number of jobs to start) for deficit round robin
+    struct TTenant
+    {
+        TJob *        head;
+        TJob *        tail;
+        unsigned int  weight;
+        unsigned int  deficit;
+        TTenantStats  stats;
+    };
+
+    std::vector< TTenant >   _tenants;
+
+    // tenant currently served and number of jobs in tenant queues
+    unsigned int             _tenant_cursor;
+    unsigned int             _tenant_jobs;
+    
+    // number of jobs in all queues and number of submissions
+    volatile unsigned int    _queue_size;
+    unsigned long            _queue_seq;
+
+    // number of currently executed jobs
+    unsigned int             _busy;
+
+    // number of threads waiting in "run" for space in job queue
+    unsigned int             _submitters;
+
+    // number of threads waiting in "sync_all" for an idle pool
+    unsigned int             _sync_waiters;
+
+    // indicates end of pool, e.g. threads finish if queue is empty
+    volatile bool            _end;
+
+    // indicates finished shutdown, e.g. all threads are joined
+    bool                     _down;
+
+    // statistics
+    TStats                   _stats;
+
+    // state of auto-tuning: time of last and next adjustment, executed jobs
+    // and throughput at last adjustment and direction of last step
+    double                   _tune_time, _tune_next;
+    unsigned long            _tune_executed;
+    double                   _tune_throughput;
+    int                      _tune_dir;
+
+    char                     _pad_queue[ CACHE_LINE_SIZE ];
+    
+    //
+    // state of idle threads
+    //
+    
+    // number of threads spinning for work (not blocked)
+    volatile int             _spinning;
+
+    // eventcount for threads waiting for work
+    TEventCount              _work_event;
+
+    // number of threads in blocking regions
+    volatile int             _blocked;
+
+    // number of threads executing jobs (set by auto-tuning)
+    volatile unsigned int    _active_limit;
+
+    char                     _pad_idle[ CACHE_LINE_SIZE ];
+
+    //
+    // management of threads
+    //
     
-    // list of idle threads
-    std::list< TPoolThr * >  _idle_threads;
+    // array of threads, handled by pool, and size of array
+    TPoolThr **              _threads;
+    unsigned int             _thread_slots;
+
+    // memory of threads: one block of consecutive slots per growth of
+    // the thread array (threads never move), each slot is aligned and
+    // padded to cache lines
+    struct TThreadBlock
+    {
+        char *        mem;
+        unsigned int  first;
+    };
+
+    std::vector< TThreadBlock >  _thread_blocks;
+
+    // attributes of threads (name is used as prefix)
+    TThreadAttr              _attr;
+
+    // number of threads being created and indicates end of thread creation
+    unsigned int             _spawning;
+    bool                     _spawn_closed;
+
+    // condition guarding above thread data
+    TCondition               _thread_cond;
+
+    // mutex for serialising "resize", "shutdown" and "run_on_all"
+    TMutex                   _resize_mutex;
+
+    // barrier of threads in "run_on_all"
+    TBarrier *               _spmd_barrier;
 
-    // condition for synchronisation of idle list
+    // condition for parked threads (spare threads or parked by auto-tuning)
+    // and indicates exit of spare threads (during "resize")
+    TCondition               _spare_cond;
+    volatile bool            _spare_exit;
+
+    // worker-local slots and mutex guarding them
+    struct TSlot
+    {
+        slot_init_t  init;
+        slot_done_t  done;
+        void *       arg;
+    };
+
+    std::vector< TSlot >     _slots;
+    TMutex                   _slot_mutex;
+
+    // condition for synchronisation with finished jobs
     TCondition               _idle_cond;
 
+    // condition for threads waiting for space in job queue
+    TCondition               _space_cond;
+
+    // timer wheel for delayed and periodic jobs (created on demand)
+    TTimerWheel *            _timers;
+    TMutex                   _timer_mutex;
+
     // @endcond
     
 public:
@@ -111,12 +672,23 @@ public:
     // constructor and destructor
     //
 
-    //! construct thread pool with \a max_p threads
-    TPool ( const unsigned int  max_p );
+    //! construct thread pool with \a max_p threads (AUTO_SIZE: number of
+    //! available processors) using attributes \a attr; a given name is
+    //! extended by the thread number, e.g. "pool-io-3";
+    //! threads are started according to \a startup
+    TPool ( const unsigned int   max_p,
+            const TThreadAttr &  attr    = TThreadAttr(),
+            const startup_t      startup = STARTUP_EAGER );
 
-    //! wait for all threads to finish and destruct thread pool 
+    //! wait for all jobs to finish and destruct thread pool (see "shutdown")
     ~TPool ();
 
+    //! finish all threads of the pool and wait for them; with \a mode
+    //! SHUTDOWN_DRAIN all queued jobs are executed before, with SHUTDOWN_DISCARD
+    //! queued jobs are dropped and only running jobs are finished;
+    //! afterwards, no jobs are accepted anymore
+    void  shutdown ( const shutdown_t  mode = SHUTDOWN_DRAIN );
+
     ///////////////////////////////////////////////
     //
     // access local variables
@@ -124,6 +696,156 @@ public:
 
     //! return number of internal threads, e.g. maximal parallel degree
     unsigned int  max_parallel () const { return _max_parallel; }
+
+    //! return number of started threads (at most max_parallel)
+    unsigned int  started_threads () const { return atomic_load( _started ); }
+
+    //! change number of threads to \a max_p (AUTO_SIZE: number of available
+    //! processors is determined again); new threads are started according
+    //! to startup mode, surplus threads finish their current job and are joined
+    void          resize       ( const unsigned int  max_p );
+
+    //! return attributes of threads
+    const TThreadAttr &  thread_attr () const { return _attr; }
+
+    //! set \a policy of "run" if \a max_queued jobs are waiting in
+    //! job queue (0: unlimited queue, policy is never applied)
+    void          set_saturation ( const saturation_t  policy,
+                                   const unsigned int  max_queued );
+
+    //! return saturation policy
+    saturation_t  saturation     () const { return _saturation; }
+
+    //! return maximal number of queued jobs before applying saturation policy
+    unsigned int  max_queued     () const { return _max_queued; }
+
+    //! set maximal number of jobs in job queue to \a n (0: unlimited);
+    //! this limit also holds if no saturation policy is defined
+    void          set_capacity   ( const unsigned int  n );
+
+    //! return maximal number of jobs in job queue (0: unlimited)
+    unsigned int  capacity       () const { return _capacity; }
+
+    //! set order of execution of queued jobs (jobs already queued for
+    //! EDF are executed before jobs queued later for FIFO)
+    void          set_schedule   ( const schedule_t  schedule );
+
+    //! return order of execution of queued jobs
+    schedule_t    schedule       () const { return _schedule; }
+
+    //! add tenant with \a weight for SCHEDULE_FAIR, e.g. while jobs of
+    //! several tenants are queued, each tenant gets a share of the started
+    //! jobs proportional to its weight; return id of tenant (tenant 0
+    //! exists with weight 1)
+    unsigned int  add_tenant        ( const unsigned int  weight = 1 );
+
+    //! set \a weight of tenant \a id
+    void          set_tenant_weight ( const unsigned int  id,
+                                      const unsigned int  weight );
+
+    //! return number of tenants
+    unsigned int  tenants           ();
+
+    //! return statistics of tenant \a id
+    TTenantStats  tenant_stats      ( const unsigned int  id );
+
+    //! return statistics of pool
+    TStats        stats          ();
+
+    //! reset statistics of pool
+    void          reset_stats    ();
+
+    //! set strategy of idle threads and of "sync": with WAIT_ADAPTIVE,
+    //! threads first spin \a spins rounds, then yield the processor
+    //! \a yields times, before blocking; with WAIT_BUSY, threads spin
+    //! without blocking (only useful with a processor per thread;
+    //! no spinning at all on a single processor)
+    void          set_wait_strategy ( const wait_t        strategy,
+                                      const unsigned int  spins  = 1000,
+                                      const unsigned int  yields = 16 );
+
+    //! return wait strategy
+    wait_t        wait_strategy  () const { return _wait; }
+
+    //! if \a seq is true, "run" executes all jobs in calling thread,
+    //! e.g. for debugging (default: value of THR_SEQUENTIAL)
+    void          set_sequential ( const bool  seq ) { _sequential = seq; }
+
+    //! return true if jobs are executed in calling thread
+    bool          sequential     () const { return _sequential; }
+
+    //! set maximal number of spare threads started for jobs in blocking
+    //! regions to \a n (default: max_parallel)
+    void          set_max_spare  ( const unsigned int  n );
+
+    //! enable (or disable) auto-tuning of the number of active threads by
+    //! hill climbing on the throughput (executed jobs per second): every
+    //! \a interval seconds, while jobs are queued, the number of active
+    //! threads is changed by one within [\a min_threads, \a max_threads]
+    //! (at most max_parallel), in the previous direction if the
+    //! throughput increased, otherwise in the opposite direction; other
+    //! threads are parked
+    void          set_auto_tune  ( const bool          enable,
+                                   const unsigned int  min_threads = 1,
+                                   const unsigned int  max_threads = UINT_MAX,
+                                   const double        interval    = 0.1 );
+
+    //! report finished jobs to \a cq (NULL: none) unless their group has a
+    //! completion queue (only affects jobs submitted afterwards; see
+    //! TCompletionQueue)
+    void          set_completion_queue ( TCompletionQueue *  cq ) { _completion = cq; }
+
+    //! return completion queue of pool (or NULL)
+    TCompletionQueue * completion_queue () const { return _completion; }
+
+    //! return true if auto-tuning is enabled
+    bool          auto_tune      () const { return _tune; }
+
+    //! return number of active threads
+    unsigned int  active_limit   () const;
+
+    //! return maximal number of spare threads
+    unsigned int  max_spare      () const { return _max_spare; }
+
+    //! return number of threads in blocking regions
+    unsigned int  blocked        () const { return atomic_load( _blocked ); }
+
+    //! let threads execute jobs only with a token of \a budget (NULL: no
+    //! budget), of which at least \a min_threads tokens are reserved
+    //! for the pool and at most \a max_threads are used; return false if
+    //! \a min_threads tokens are not available (to be called while no
+    //! jobs are running; jobs of "run_on_all" need no tokens)
+    bool          set_budget     ( TThreadBudget *     budget,
+                                   const unsigned int  min_threads = 0,
+                                   const unsigned int  max_threads = UINT_MAX );
+
+    //! return budget of pool (or NULL)
+    TThreadBudget * budget       () const { return _budget; }
+
+    //! set minimal chunk size of arenas of threads to \a chunk_size and
+    //! back them by huge pages if \a huge_pages is true (only affects
+    //! arenas not yet created, see worker_arena)
+    void          set_arena      ( const size_t  chunk_size,
+                                   const bool    huge_pages = false );
+
+    //! return arena of calling thread for temporary memory of jobs, which
+    //! is reset after each job (NULL if not called by a thread of a pool);
+    //! the arena is created on first use
+    static TArena *  worker_arena ();
+
+    //! register worker-local slot: each thread calls \a init at start (or,
+    //! if already running, on first access to the slot) and \a done at
+    //! termination with the slot data, both with \a arg; return slot id
+    unsigned int     add_slot     ( slot_init_t   init,
+                                    slot_done_t   done = NULL,
+                                    void *        arg  = NULL );
+
+    //! return data of slot \a id of calling thread (NULL if not called by
+    //! a thread of a pool or if \a id is not registered)
+    static void *    worker_slot  ( const unsigned int  id );
+
+    //! return number of calling thread in its pool (-1 if not a thread of a pool)
+    static int       worker_index ();
     
     ///////////////////////////////////////////////
     //
@@ -133,27 +855,244 @@ public:
     //! enqueue \a job in thread pool, e.g. execute \a job by the first freed thread
     //! - \a ptr is an optional argument passed to the "run" method of \a job
     //! - if \a del is true, the job object will be deleted after finishing "run"
-    void  run  ( TJob *      job,
+    //! - if the job queue is saturated, the saturation policy is applied
+    //! - returns false if the job was rejected (and hence not deleted)
+    bool  run  ( TJob *      job,
                  void *      ptr = NULL,
                  const bool  del = false );
 
+    //! enqueue \a job in thread pool if the job queue is not full (with
+    //! respect to the capacity); otherwise return false immediately
+    //! (no saturation policy is applied, the job is not deleted)
+    bool  try_run ( TJob *      job,
+                    void *      ptr = NULL,
+                    const bool  del = false );
+
+    //! enqueue \a job in thread pool and wait at most \a timeout seconds
+    //! for space in a full job queue; return false on timeout
+    //! (no saturation policy is applied, the job is not deleted)
+    bool  run_for ( TJob *        job,
+                    const double  timeout,
+                    void *        ptr = NULL,
+                    const bool    del = false );
+
     //! synchronise with \a job, i.e. wait until finished
     void  sync ( TJob * job );
 
     //! synchronise with all running jobs
     void  sync_all ();
 
+    //! synchronise with all jobs in \a group
+    void  sync     ( TJobGroup & group );
+
+    //! synchronise with \a job but wait at most \a timeout seconds
+    sync_t  sync_for       ( TJob *        job,
+                             const double  timeout );
+
+    //! synchronise with \a job but wait at most until monotonic time
+    //! \a deadline (see monotonic_time)
+    sync_t  sync_until     ( TJob *        job,
+                             const double  deadline );
+
+    //! synchronise with all jobs in \a group but wait at most \a timeout seconds
+    sync_t  sync_for       ( TJobGroup &   group,
+                             const double  timeout );
+
+    //! synchronise with all jobs in \a group but wait at most until
+    //! monotonic time \a deadline
+    sync_t  sync_until     ( TJobGroup &   group,
+                             const double  deadline );
+
+    //! synchronise with all jobs but wait at most \a timeout seconds
+    sync_t  sync_all_for   ( const double  timeout );
+
+    //! synchronise with all jobs but wait at most until monotonic time \a deadline
+    sync_t  sync_all_until ( const double  deadline );
+
+    //! execute \a f with \a arg by max_parallel threads at once, each with a
+    //! different rank, and wait until all have finished; the threads may
+    //! synchronise via "barrier"; return false if pool was shut down
+    //! (not to be called by pool threads; "resize" waits until finished)
+    bool  run_on_all ( spmd_func_t  f,
+                       void *       arg = NULL );
+
+    //! wait until all threads in "run_on_all" have called "barrier";
+    //! return true for exactly one thread (the last arriving)
+    bool  barrier    () { return ( _spmd_barrier != NULL ? _spmd_barrier->arrive_and_wait() : true ); }
+
+    //! cancel \a job, e.g. remove it from job queue or, if already
+    //! running, set cancellation flag
+    void  cancel   ( TJob * job );
+
+    //! cancel all jobs in group \a group, e.g. remove them from the job queue
+    //! and set cancellation flag of group for running jobs
+    void  cancel   ( TJobGroup & group );
+
+    ///////////////////////////////////////////////
+    //
+    // delayed and periodic jobs
+    //
+
+    //! enqueue \a job after \a delay seconds; arguments \a ptr and \a del
+    //! are as for "run"; sync(job) and sync of its group wait until the
+    //! delayed job has finished and cancel(job) before the delay has passed
+    //! drops the job when due
+    TTimerId  run_after   ( const double  delay,
+                            TJob *        job,
+                            void *        ptr = NULL,
+                            const bool    del = false );
+
+    //! enqueue \a job every \a period seconds (first after \a period) until
+    //! cancelled; a period is skipped if the previous run has not yet finished
+    TTimerId  run_every   ( const double  period,
+                            TJob *        job,
+                            void *        ptr = NULL );
+
+    //! cancel delayed or periodic job with handle \a id; return true if the
+    //! timer was still pending (delayed jobs are then released without being
+    //! executed like dropped jobs, e.g. deleted if requested, removed from
+    //! their group and reported to the completion queue)
+    bool      cancel_timer ( const TTimerId  id );
+
 protected:
     ///////////////////////////////////////////////
     //
-    // manage pool threads
+    // manage job queue
     //
 
-    //! return idle thread from pool
-    TPoolThr * get_idle ();
+    //! result of appending a job to the queue
+    enum push_t { PUSH_OK, PUSH_FULL, PUSH_CLOSED };
+
+    //! append already locked \a job to job queue and wake a thread unless
+    //! \a limit jobs are queued or pool was shut down (\a retry: repeated
+    //! push of same job, not counted in statistics)
+    push_t    push        ( TJob *              job,
+                            void *              ptr,
+                            const bool          del,
+                            const unsigned int  limit,
+                            const bool          retry = false );
+
+    //! append already locked \a job to job queue with at most \a limit
+    //! jobs; if full, wait until monotonic time \a deadline (forever if
+    //! negative)
+    push_t    push_wait   ( TJob *              job,
+                            void *              ptr,
+                            const bool          del,
+                            const bool          saturation,
+                            const double        deadline );
+
+    //! return maximal number of queued jobs for submission (with or
+    //! without saturation limit)
+    unsigned int  queue_limit ( const bool  saturation ) const;
 
-    //! insert idle thread into pool
-    void append_idle ( TPoolThr * t );
+    //! release locked \a job after unsuccessful push with result \a res
+    bool      reject      ( TJob *        job,
+                            const push_t  res,
+                            const char *  func );
+
+    //! execute already locked \a job in calling thread
+    void         run_inline ( TJob *      job,
+                              void *      ptr,
+                              const bool  del );
+
+    //! append already locked \a job to job queue and wake a thread
+    //! (job is dropped if pool was shut down)
+    void      enqueue     ( TJob *      job,
+                            void *      ptr,
+                            const bool  del );
+
+    //! append due delayed \a job of timer wheel to job queue (job was
+    //! accounted in its group by "run_after")
+    void      enqueue_delayed ( TJob *      job,
+                                void *      ptr,
+                                const bool  del );
+
+    //! release pending delayed \a job of timer wheel without execution,
+    //! e.g. at cancellation or shutdown (as "purge")
+    void      drop_delayed    ( TJob *      job,
+                                const bool  del );
+
+    //! start another thread unless max_parallel threads (plus \a spares
+    //! spare threads) are started; return true if a thread was started
+    bool      spawn       ( const unsigned int  spares = 0 );
+
+    //! extend array of threads to \a nslots slots and allocate memory
+    //! for new threads ("_thread_cond" must be locked)
+    void      grow_threads  ( const unsigned int  nslots );
+
+    //! return memory of thread in slot \a i
+    void *    thread_memory ( const unsigned int  i ) const;
+
+    //! return true if thread \a thr_no may not execute jobs, e.g. it was
+    //! removed by "resize", is a spare thread not needed or was parked by
+    //! auto-tuning
+    bool      retired     ( const unsigned int  thr_no ) const;
+
+    //! return true if retired thread \a thr_no finishes instead of parking
+    bool      exiting     ( const unsigned int  thr_no ) const;
+
+    //! adjust number of active threads at time \a now (with _work_mutex
+    //! locked); return true if threads were activated
+    bool      tune        ( const double  now );
+
+    //! account for thread entering and leaving blocking region; the
+    //! \a token of the thread budget is returned during the region
+    void      enter_blocking ( const bool  token );
+    void      leave_blocking ( const bool  token );
+
+    //! account for previous job if \a done (dropped if not \a executed,
+    //! finished after its deadline if \a missed) and return next job from
+    //! queue or NULL if pool has ended or thread \a thr_no was removed by
+    //! "resize" (called by threads); \a token indicates a token of the
+    //! thread budget held by the thread
+    TJob *    dequeue     ( const unsigned int  thr_no,
+                            const bool          done,
+                            const bool          executed,
+                            const bool          missed,
+                            bool &              token );
+
+    //! append \a job to FIFO or deadline queue (with _work_mutex locked)
+    void      queue_append ( TJob *  job );
+
+    //! remove and return next job from queues (with _work_mutex locked)
+    TJob *    queue_pop    ();
+
+    //! remove all jobs for which \a pred( job, arg ) is true from list
+    //! starting at \a head and prepend them to \a dropped; return number
+    //! of removed jobs
+    static unsigned int  purge_list ( TJob *&        head,
+                                      TJob *&        tail,
+                                      bool (* pred) ( const TJob *, const void * ),
+                                      const void *   arg,
+                                      TJob *&        dropped );
+
+    //! return true if \a a is executed after \a b in deadline queue
+    static bool  later_deadline ( const TJob *  a,
+                                  const TJob *  b );
+
+    //! spin according to wait strategy until job queue is not empty,
+    //! pool has ended or thread \a thr_no was removed; return false if
+    //! thread should block
+    bool      spin_wait   ( const unsigned int  thr_no ) const;
+
+    //! remove all queued jobs for which \a pred( job, arg ) is true and
+    //! release them without execution
+    void      purge       ( bool (* pred) ( const TJob *, const void * ),
+                            const void *  arg );
+
+    //! release \a job without execution (unlock and delete if requested)
+    static void  drop     ( TJob * job );
+
+    //! release executed or dropped \a job: unlock and delete if \a del,
+    //! otherwise report to its completion queue
+    static void  finish   ( TJob *      job,
+                            const bool  del );
+
+    //! return completion queue for \a job (of group or of pool)
+    TCompletionQueue * completion_for ( const TJob *  job ) const;
+
+    //! return timer wheel (create if not yet existing); "_timer_mutex" must be locked
+    TTimerWheel * timers  ();
 };
 
 ///////////////////////////////////////////////////
@@ -162,11 +1101,29 @@ protected:
 //
 ///////////////////////////////////////////////////
 
-//! init global thread_pool with \a max_p threads
-void  init      ( const unsigned int   max_p );
+//! init global thread_pool with \a max_p threads (TPool::AUTO_SIZE: number
+//! of available processors) using attributes \a attr and start mode \a startup
+void  init      ( const unsigned int      max_p,
+                  const TThreadAttr &     attr    = TThreadAttr(),
+                  const TPool::startup_t  startup = TPool::STARTUP_EAGER );
+
+//! change number of threads of global thread pool to \a max_p
+void  resize    ( const unsigned int   max_p );
 
 //! run \a job in global thread pool with \a ptr passed to job->run()
-void  run       ( TPool::TJob *        job,
+bool  run       ( TPool::TJob *        job,
+                  void *               ptr = NULL,
+                  const bool           del = false );
+
+//! run \a job in global thread pool if queue is not full
+bool  try_run   ( TPool::TJob *        job,
+                  void *               ptr = NULL,
+                  const bool           del = false );
+
+//! run \a job in global thread pool, wait at most \a timeout seconds
+//! for space in queue
+bool  run_for   ( TPool::TJob *        job,
+                  const double         timeout,
                   void *               ptr = NULL,
                   const bool           del = false );
 
@@ -176,8 +1133,39 @@ void  sync      ( TPool::TJob *        job );
 //! synchronise with all jobs
 void  sync_all  ();
 
-//! finish global thread pool
-void  done      ();
+//! synchronise with \a job, wait at most \a timeout seconds
+TPool::sync_t  sync_for       ( TPool::TJob *       job,
+                                const double        timeout );
+
+//! synchronise with all jobs of \a group, wait at most \a timeout seconds
+TPool::sync_t  sync_for       ( TPool::TJobGroup &  group,
+                                const double        timeout );
+
+//! synchronise with all jobs, wait at most \a timeout seconds
+TPool::sync_t  sync_all_for   ( const double        timeout );
+
+//! cancel \a job in global thread pool
+void  cancel    ( TPool::TJob *        job );
+
+//! cancel all jobs of \a group in global thread pool
+void  cancel    ( TPool::TJobGroup &   group );
+
+//! run \a job in global thread pool after \a delay seconds
+TTimerId  run_after    ( const double   delay,
+                         TPool::TJob *  job,
+                         void *         ptr = NULL,
+                         const bool     del = false );
+
+//! run \a job in global thread pool every \a period seconds
+TTimerId  run_every    ( const double   period,
+                         TPool::TJob *  job,
+                         void *         ptr = NULL );
+
+//! cancel delayed or periodic job in global thread pool
+bool      cancel_timer ( const TTimerId  id );
+
+//! finish global thread pool (see TPool::shutdown for \a mode)
+void  done      ( const TPool::shutdown_t  mode = TPool::SHUTDOWN_DRAIN );
 
 }// ThreadPool
 
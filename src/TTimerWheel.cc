@@ -0,0 +1,445 @@
+//
+//  Project : ThreadPool
+//  File    : TTimerWheel.cc
+//  Author  : Ronald Kriemann
+//  Purpose : hierarchical timer wheel for delayed and periodic jobs
+//
+
+#include <cmath>
+
+#include "TTimerWheel.hh"
+
+namespace ThreadPool
+{
+
+namespace
+{
+
+//
+// return true if tick a is before tick b (handles wrap around)
+//
+inline bool
+before ( const unsigned long  a, const unsigned long  b )
+{
+    return long( a - b ) < 0;
+}
+
+//
+// maximal number of ticks of a delay or period, e.g. expiry ticks are
+// still ordered correctly by "before" (timers beyond the levels of the
+// wheel are cascaded until due)
+//
+const unsigned long  MAX_TICKS = ~0UL >> 2;
+
+//
+// return given number of ticks clamped to [0,MAX_TICKS] (also for
+// infinite or undefined values)
+//
+inline unsigned long
+clamp_ticks ( const double  ticks )
+{
+    if ( ticks <= 0.0 )
+        return 0;
+
+    if ( ! ( ticks < double( MAX_TICKS ) ))
+        return MAX_TICKS;
+
+    return static_cast< unsigned long >( ticks );
+}
+
+}// namespace anonymous
+
+////////////////////////////////////////////
+//
+// constructor and destructor
+//
+
+TTimerWheel::TTimerWheel ( TPool *       pool,
+                           const double  tick )
+        : _pool( pool ), _tick( tick ), _start( monotonic_time() ),
+          _now( 0 ), _wake( 0 ), _nodes( SENTINELS ), _free( 0 ),
+          _count( 0 ), _end( false )
+{
+    // initialise empty slots
+    for ( unsigned int  i = 0; i < SENTINELS; i++ )
+    {
+        _nodes[i].prev = i;
+        _nodes[i].next = i;
+        _nodes[i].gen  = 0;
+    }// for
+
+    create( false, false );
+}
+
+TTimerWheel::~TTimerWheel ()
+{
+    {
+        TScopedLock  lock( _cond );
+
+        _end = true;
+        _cond.signal();
+    }
+
+    join();
+
+    //
+    // drop pending timers: delayed jobs were locked and have to be released
+    //
+
+    for ( unsigned int  s = 0; s < SENTINELS; s++ )
+    {
+        unsigned int  n = _nodes[s].next;
+
+        while ( n != s )
+        {
+            const TNode &  node = _nodes[n];
+
+            if ( node.period == 0 )
+                _pool->drop_delayed( node.job, node.del );
+
+            n = node.next;
+        }// while
+    }// for
+}
+
+////////////////////////////////////////////
+//
+// timer management
+//
+
+//
+// add new timer
+//
+TTimerId
+TTimerWheel::add ( const double   delay,
+                   const double   period,
+                   TPool::TJob *  job,
+                   void *         ptr,
+                   const bool     del )
+{
+    TScopedLock   lock( _cond );
+    const double  now = monotonic_time();
+
+    // empty wheel: no need to step through elapsed ticks
+    if ( _count == 0 )
+    {
+        const unsigned long  cur = static_cast< unsigned long >( std::floor( (now - _start) / _tick ) );
+
+        if ( before( _now, cur ) )
+            _now = cur;
+    }// if
+
+    //
+    // get free node
+    //
+
+    unsigned int  n = _free;
+
+    if ( n != 0 )
+        _free = _nodes[n].next;
+    else
+    {
+        n = _nodes.size();
+        _nodes.push_back( TNode() );
+        _nodes[n].gen = 0;
+    }// else
+
+    TNode &  node = _nodes[n];
+
+    if ( ++node.gen == 0 )
+        node.gen = 1;
+
+    node.expires = to_tick( now + delay );
+    node.period  = 0;
+    node.job     = job;
+    node.ptr     = ptr;
+    node.del     = del;
+
+    if ( period > 0.0 )
+    {
+        node.period = clamp_ticks( std::floor( period / _tick + 0.5 ) );
+
+        if ( node.period == 0 )
+            node.period = 1;
+    }// if
+
+    insert( n );
+    _count++;
+
+    // wake timer thread if it sleeps beyond new expiry time
+    if ( before( node.expires, _wake ) )
+        _cond.signal();
+
+    return TTimerId( n, node.gen );
+}
+
+//
+// cancel timer
+//
+bool
+TTimerWheel::cancel ( const TTimerId  id )
+{
+    TPool::TJob *  job = NULL;
+    bool           del = false;
+
+    {
+        TScopedLock  lock( _cond );
+
+        if (( id.slot < SENTINELS ) || ( id.slot >= _nodes.size() ) ||
+            ( _nodes[ id.slot ].gen != id.gen ))
+            return false;
+
+        const TNode &  node = _nodes[ id.slot ];
+
+        // delayed jobs are locked and have to be released
+        if ( node.period == 0 )
+        {
+            job = node.job;
+            del = node.del;
+        }// if
+
+        unlink( id.slot );
+        release( id.slot );
+        _count--;
+    }
+
+    if ( job != NULL )
+        _pool->drop_delayed( job, del );
+
+    return true;
+}
+
+//
+// return number of pending timers
+//
+unsigned int
+TTimerWheel::pending ()
+{
+    TScopedLock  lock( _cond );
+
+    return _count;
+}
+
+//
+// timer thread: advance wheel and enqueue due jobs
+//
+void
+TTimerWheel::run ()
+{
+    TScopedLock  lock( _cond );
+
+    while ( ! _end )
+    {
+        const double         now = monotonic_time();
+        const unsigned long  cur = static_cast< unsigned long >( std::floor( (now - _start) / _tick ) );
+
+        // handle all elapsed ticks
+        while ( ! before( cur, _now ) )
+            advance();
+
+        // sleep until next tick with due timers
+        if ( _count == 0 )
+        {
+            _wake = _now + (~0UL >> 1);
+            _cond.wait();
+        }// if
+        else
+        {
+            _wake = next_tick();
+            _cond.wait_until( _start + double( _wake ) * _tick );
+        }// else
+    }// while
+}
+
+////////////////////////////////////////////
+//
+// internal methods
+//
+
+//
+// return tick for given time (rounded up), at most MAX_TICKS after
+// current tick (e.g. for huge, infinite or undefined delays)
+//
+unsigned long
+TTimerWheel::to_tick ( const double  t ) const
+{
+    const double  ticks = std::ceil( (t - _start) / _tick );
+
+    if ( ticks <= double( _now ) )
+        return clamp_ticks( ticks );
+
+    return _now + clamp_ticks( ticks - double( _now ) );
+}
+
+//
+// insert node into slot corresponding to expiry tick
+//
+void
+TTimerWheel::insert ( const unsigned int  n )
+{
+    TNode &        node    = _nodes[n];
+    unsigned long  expires = node.expires;
+    unsigned long  diff    = expires - _now;
+    unsigned int   s;
+
+    if ( before( expires, _now ) )
+    {
+        // already due: handle in current tick
+        s = _now & (ROOT_SLOTS-1);
+    }// if
+    else if ( diff < (1UL << ROOT_BITS) )
+    {
+        s = expires & (ROOT_SLOTS-1);
+    }// if
+    else if ( diff < (1UL << (ROOT_BITS + LVL_BITS)) )
+    {
+        s = ROOT_SLOTS + ((expires >> ROOT_BITS) & (LVL_SLOTS-1));
+    }// if
+    else if ( diff < (1UL << (ROOT_BITS + 2*LVL_BITS)) )
+    {
+        s = ROOT_SLOTS + LVL_SLOTS + ((expires >> (ROOT_BITS + LVL_BITS)) & (LVL_SLOTS-1));
+    }// if
+    else
+    {
+        // timers beyond the range of the wheel are put into the last
+        // slot and re-inserted upon cascading
+        const unsigned long  max_diff = (1UL << (ROOT_BITS + LEVELS*LVL_BITS)) - 1;
+
+        if ( diff > max_diff )
+            expires = _now + max_diff;
+
+        s = ROOT_SLOTS + 2*LVL_SLOTS + ((expires >> (ROOT_BITS + 2*LVL_BITS)) & (LVL_SLOTS-1));
+    }// else
+
+    // append to slot list
+    node.next = s;
+    node.prev = _nodes[s].prev;
+    _nodes[ node.prev ].next = n;
+    _nodes[s].prev = n;
+}
+
+//
+// remove node from slot
+//
+void
+TTimerWheel::unlink ( const unsigned int  n )
+{
+    TNode &  node = _nodes[n];
+
+    _nodes[ node.prev ].next = node.next;
+    _nodes[ node.next ].prev = node.prev;
+    node.prev = node.next = n;
+}
+
+//
+// move all timers in slot <idx> of level <lvl> to lower levels
+//
+unsigned int
+TTimerWheel::cascade ( const unsigned int  lvl,
+                       const unsigned int  idx )
+{
+    const unsigned int  s = ROOT_SLOTS + (lvl-1) * LVL_SLOTS + idx;
+    unsigned int        n = _nodes[s].next;
+
+    // detach list from slot and re-insert all timers
+    _nodes[s].next = _nodes[s].prev = s;
+
+    while ( n != s )
+    {
+        const unsigned int  next = _nodes[n].next;
+
+        insert( n );
+        n = next;
+    }// while
+
+    return idx;
+}
+
+//
+// handle current tick and enqueue due jobs
+//
+void
+TTimerWheel::advance ()
+{
+    const unsigned int  idx = _now & (ROOT_SLOTS-1);
+
+    // refill first level from higher levels
+    if (( idx == 0 ) &&
+        ( cascade( 1, (_now >> ROOT_BITS) & (LVL_SLOTS-1) ) == 0 ) &&
+        ( cascade( 2, (_now >> (ROOT_BITS + LVL_BITS)) & (LVL_SLOTS-1) ) == 0 ))
+        cascade( 3, (_now >> (ROOT_BITS + 2*LVL_BITS)) & (LVL_SLOTS-1) );
+
+    // detach due timers
+    unsigned int  n = _nodes[idx].next;
+
+    _nodes[idx].next = _nodes[idx].prev = idx;
+    _now++;
+
+    while ( n != idx )
+    {
+        TNode &             node = _nodes[n];
+        const unsigned int  next = node.next;
+
+        if ( node.period == 0 )
+        {
+            // delayed job is already locked
+            _pool->enqueue_delayed( node.job, node.ptr, node.del );
+            release( n );
+            _count--;
+        }// if
+        else
+        {
+            // skip periodic job if previous run is not finished
+            if ( node.job->try_lock() )
+                _pool->enqueue( node.job, node.ptr, false );
+
+            node.expires += node.period;
+
+            if ( before( node.expires, _now ) )
+                node.expires = _now;
+
+            insert( n );
+        }// else
+
+        n = next;
+    }// while
+}
+
+//
+// return next tick with possibly due timers
+//
+unsigned long
+TTimerWheel::next_tick () const
+{
+    // timers in first level expire before next cascade
+    const unsigned long  boundary = (_now | (ROOT_SLOTS-1)) + 1;
+
+    for ( unsigned long  t = _now; t != boundary; t++ )
+    {
+        const unsigned int  s = t & (ROOT_SLOTS-1);
+
+        if ( _nodes[s].next != s )
+            return t;
+    }// for
+
+    return boundary;
+}
+
+//
+// put node into free list
+//
+void
+TTimerWheel::release ( const unsigned int  n )
+{
+    TNode &  node = _nodes[n];
+
+    // invalidate handles to node
+    if ( ++node.gen == 0 )
+        node.gen = 1;
+
+    node.job  = NULL;
+    node.next = _free;
+    _free     = n;
+}
+
+}// namespace ThreadPool
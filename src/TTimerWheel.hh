@@ -0,0 +1,147 @@
+#ifndef __TTIMERWHEEL_HH
+#define __TTIMERWHEEL_HH
+//
+//  Project : ThreadPool
+//  File    : TTimerWheel.hh
+//  Author  : Ronald Kriemann
+//  Purpose : hierarchical timer wheel for delayed and periodic jobs
+//
+
+#include <vector>
+
+#include "TThreadPool.hh"
+
+namespace ThreadPool
+{
+
+//!
+//! \class  TTimerWheel
+//! \brief  hierarchical timer wheel serviced by a single thread, which
+//!         enqueues jobs into a thread pool when due
+//!         - insertion and cancellation of timers is O(1)
+//!         - timers are handled with a resolution of one tick
+//!
+class TTimerWheel : public TThread
+{
+protected:
+    // @cond
+
+    // number of bits and slots in first and higher levels of the wheel
+    enum { ROOT_BITS  = 8,
+           ROOT_SLOTS = 1 << ROOT_BITS,
+           LVL_BITS   = 6,
+           LVL_SLOTS  = 1 << LVL_BITS,
+           LEVELS     = 3,
+           SENTINELS  = ROOT_SLOTS + LEVELS * LVL_SLOTS };
+
+    // timer node; timers are stored in circular doubly linked lists
+    // with a sentinel node per slot (stored in _nodes)
+    struct TNode
+    {
+        unsigned int   prev, next;
+        unsigned int   gen;
+        unsigned long  expires;
+        unsigned long  period;
+        TPool::TJob *  job;
+        void *         ptr;
+        bool           del;
+    };
+
+    // pool to execute jobs in
+    TPool *               _pool;
+
+    // length of a tick in seconds and start time of wheel
+    const double          _tick;
+    const double          _start;
+
+    // current tick, e.g. all ticks before were handled
+    unsigned long         _now;
+
+    // tick the timer thread sleeps until
+    unsigned long         _wake;
+
+    // sentinel and timer nodes
+    std::vector< TNode >  _nodes;
+
+    // first free node (0: no free node)
+    unsigned int          _free;
+
+    // number of pending timers
+    unsigned int          _count;
+
+    // indicates end of timer thread
+    bool                  _end;
+
+    // condition guarding the above data
+    TCondition            _cond;
+
+    // @endcond
+
+public:
+    ///////////////////////////////////////////////
+    //
+    // constructor and destructor
+    //
+
+    //! construct timer wheel for \a pool with a resolution of
+    //! \a tick seconds and start timer thread
+    TTimerWheel ( TPool *       pool,
+                  const double  tick = 1e-3 );
+
+    //! stop timer thread and drop all pending timers
+    ~TTimerWheel ();
+
+    ///////////////////////////////////////////////
+    //
+    // timer management
+    //
+
+    //! enqueue \a job into pool after \a delay seconds and afterwards every
+    //! \a period seconds (if positive); delayed jobs have to be locked
+    //! already, periodic jobs are locked when due (and skipped if still running)
+    TTimerId      add     ( const double   delay,
+                            const double   period,
+                            TPool::TJob *  job,
+                            void *         ptr,
+                            const bool     del );
+
+    //! remove pending timer \a id, return false if no longer pending
+    bool          cancel  ( const TTimerId  id );
+
+    //! return number of pending timers
+    unsigned int  pending ();
+
+    //! run timer thread
+    void          run     ();
+
+protected:
+    // @cond
+
+    // return tick for time t, rounded up
+    unsigned long  to_tick   ( const double  t ) const;
+
+    // insert node into slot according to its expiry tick
+    void           insert    ( const unsigned int  n );
+
+    // remove node from its slot
+    void           unlink    ( const unsigned int  n );
+
+    // move all timers of slot in level lvl to lower levels
+    unsigned int   cascade   ( const unsigned int  lvl,
+                               const unsigned int  idx );
+
+    // handle current tick and enqueue due jobs into pool
+    void           advance   ();
+
+    // return next tick with possibly due timers
+    unsigned long  next_tick () const;
+
+    // release node n
+    void           release   ( const unsigned int  n );
+
+    // @endcond
+};
+
+}// namespace ThreadPool
+
+#endif  // __TTIMERWHEEL_HH
@@ -3,7 +3,15 @@
 #include <cmath>
 #include <vector>
 
+#include <semaphore.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
 #include "TThreadPool.hh"
+#include "TAlgorithms.hh"
+#include "TSync.hh"
+#include "TThreadBudget.hh"
+#include "TCompletionQueue.hh"
 #include "TTimer.hh"
 #include "TRNG.hh"
 
@@ -35,6 +43,34 @@ public:
     }
 };
 
+//
+// same as TBenchJob but with temporary memory from arena of thread
+//
+class TBenchArenaJob : public ThreadPool::TPool::TJob
+{
+protected:
+    int   _size;
+    
+public:
+    TBenchArenaJob ( int i, int s ) : ThreadPool::TPool::TJob( i ), _size(s) {}
+
+    virtual void run ( void * )
+    {
+        typedef ThreadPool::TArenaAllocator< double >  alloc_t;
+        
+        std::vector< double, alloc_t >  matrix( _size * _size, 0.0,
+                                                alloc_t( ThreadPool::TPool::worker_arena() ) );
+        
+        for ( int i = 0; i < _size; i++ )
+        {
+            for ( int j = 0; j < _size; j++ )
+            {
+                matrix[ (i*_size) + j ] = std::sin( double(j) * M_PI * std::cos( double(i) ));
+            }// for
+        }// for
+    }
+};
+
 #define MAX_SIZE  1000
 #define MAX_RAND  500
 
@@ -61,7 +97,7 @@ bench1 ( int argc, char ** argv )
 {
     TRNG  rng;
     int   i = 1;
-    int   thr_count = 16;
+    int   thr_count = ThreadPool::available_cpus();
     int   rec_depth = 6;
     
     if ( argc > 1 ) thr_count = atoi( argv[1] );
@@ -115,6 +151,8 @@ bench2 ( int argc, char ** argv )
 {
     int  max_jobs = 500000;
 
+    if ( argc > 1 ) max_jobs = atoi( argv[1] );
+    
     ThreadPool::init( 4 );
 
     TTimer  timer( REAL_TIME );
@@ -156,6 +194,48 @@ bench2 ( int argc, char ** argv )
     timer.stop();
     std::cout << "time for thread pool = " << timer << std::endl;
 
+    //
+    // run/sync latency for different wait strategies of idle threads
+    //
+
+    const ThreadPool::TPool::wait_t  wait_strategy[] = { ThreadPool::TPool::WAIT_PARK,
+                                                         ThreadPool::TPool::WAIT_ADAPTIVE,
+                                                         ThreadPool::TPool::WAIT_BUSY };
+    const char *                     wait_name[]     = { "park", "adaptive", "busy" };
+    const unsigned int               nthreads        = 4;
+
+    for ( int  w = 0; w < 3; w++ )
+    {
+        // busy waiting threads need a processor each
+        if (( wait_strategy[w] == ThreadPool::TPool::WAIT_BUSY ) &&
+            ( ThreadPool::available_cpus() < nthreads ))
+        {
+            std::cout << "time for thread pool (" << wait_name[w] << ") : skipped, less than "
+                      << nthreads << " processors" << std::endl;
+            continue;
+        }// if
+        
+        ThreadPool::TPool  pool( nthreads );
+
+        pool.set_wait_strategy( wait_strategy[w] );
+        
+        timer.start();
+    
+        for ( int i = 0; i  < max_jobs; i++ )
+        {
+            TBench2Job  * job = new TBench2Job( i );
+
+            pool.run( job );
+            pool.sync( job );
+
+            delete job;
+        }
+
+        timer.stop();
+        std::cout << "time for thread pool (" << wait_name[w] << ") = " << timer
+                  << " (" << 1e6 * timer.diff() / max_jobs << " us per job)" << std::endl;
+    }// for
+
     timer.start();
     
     for ( int i = 0; i  < max_jobs; i++ )
@@ -189,9 +269,949 @@ bench2 ( int argc, char ** argv )
     ThreadPool::done();
 }
 
+//
+// startup latency of a pool, of which only a few threads are used
+//
+void
+bench3 ( int argc, char ** argv )
+{
+    int  thr_count = 64;
+    int  job_count = 4;
+    int  rounds    = 100;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) job_count = atoi( argv[2] );
+
+    const ThreadPool::TPool::startup_t  startup[]     = { ThreadPool::TPool::STARTUP_EAGER,
+                                                          ThreadPool::TPool::STARTUP_PARALLEL,
+                                                          ThreadPool::TPool::STARTUP_LAZY };
+    const char *                        startup_name[] = { "eager", "parallel", "lazy" };
+    TTimer                              timer( REAL_TIME );
+
+    for ( int  s = 0; s < 3; s++ )
+    {
+        double  t_create = 0.0;
+        double  t_first  = 0.0;
+        double  t_total  = 0.0;
+        
+        for ( int  r = 0; r < rounds; r++ )
+        {
+            std::vector< TBench2Job * >  jobs( job_count );
+            
+            timer.start();
+
+            ThreadPool::TPool *  pool = new ThreadPool::TPool( thr_count, ThreadPool::TThreadAttr(),
+                                                               startup[s] );
+
+            timer.stop();
+            t_create += timer.diff();
+            t_total  += timer.diff();
+            timer.start();
+            
+            for ( int i = 0; i < job_count; i++ )
+            {
+                jobs[i] = new TBench2Job( i );
+                pool->run( jobs[i] );
+            }// for
+
+            pool->sync( jobs[0] );
+
+            timer.stop();
+            t_first += timer.diff();
+            t_total += timer.diff();
+            timer.start();
+            
+            pool->sync_all();
+            delete pool;
+
+            timer.stop();
+            t_total += timer.diff();
+            
+            for ( int i = 0; i < job_count; i++ )
+                delete jobs[i];
+        }// for
+
+        std::cout << "startup (" << startup_name[s] << ", " << thr_count << " threads, "
+                  << job_count << " jobs) : create = " << 1e6 * t_create / rounds
+                  << " us, first job = " << 1e6 * t_first / rounds
+                  << " us, total = " << 1e6 * t_total / rounds << " us" << std::endl;
+    }// for
+}
+
+//
+// temporary memory of jobs from heap and from arena of thread
+//
+void
+bench4 ( int argc, char ** argv )
+{
+    TRNG  rng;
+    int   thr_count = ThreadPool::available_cpus();
+    int   job_count = 256;
+    int   size      = 200;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) job_count = atoi( argv[2] );
+    if ( argc > 3 ) size      = atoi( argv[3] );
+
+    TTimer  timer( REAL_TIME );
+
+    for ( int  variant = 0; variant < 3; variant++ )
+    {
+        ThreadPool::TPool  pool( thr_count );
+
+        if ( variant == 2 )
+            pool.set_arena( 1024*1024, true );
+        
+        timer.start();
+
+        for ( int i = 0; i < job_count; i++ )
+        {
+            const int  n = size + int(rng.rand( size / 2 ));
+            
+            if ( variant == 0 ) pool.run( new TBenchJob( -1, n ), NULL, true );
+            else                pool.run( new TBenchArenaJob( -1, n ), NULL, true );
+        }// for
+
+        pool.sync_all();
+        
+        timer.stop();
+        std::cout << "time for " << job_count << " jobs with temporaries from "
+                  << ( variant == 0 ? "heap" : ( variant == 1 ? "arena" : "arena (huge pages)" ))
+                  << " = " << timer << std::endl;
+    }// for
+}
+
+//
+// per-worker counters, either packed into one array or padded to cache
+// lines like the threads of a pool (false sharing between workers)
+//
+class TWorkerCounterJob : public ThreadPool::TPool::TJob
+{
+protected:
+    volatile long *  _counters;
+    unsigned int     _stride;
+    long             _count;
+    
+public:
+    TWorkerCounterJob ( volatile long *     counters,
+                        const unsigned int  stride,
+                        const long          count )
+            : ThreadPool::TPool::TJob(), _counters( counters ), _stride( stride ), _count( count )
+    {}
+
+    virtual void run ( void * )
+    {
+        volatile long &  counter = _counters[ ThreadPool::TPool::worker_index() * _stride ];
+        
+        for ( long  i = 0; i < _count; i++ )
+            counter = counter + 1;
+    }
+};
+
+//
+// false sharing of per-worker data (packed vs. padded) and run/sync
+// throughput of empty jobs for increasing number of threads, e.g.
+// bounded by accesses of submitting and working threads to the shared
+// data of the pool
+//
+void
+bench5 ( int argc, char ** argv )
+{
+    int   max_threads = 4 * ThreadPool::available_cpus();
+    int   job_count   = 100000;
+    long  count       = 10000000;
+    
+    if ( argc > 1 ) max_threads = atoi( argv[1] );
+    if ( argc > 2 ) job_count   = atoi( argv[2] );
+    if ( argc > 3 ) count       = atol( argv[3] );
+
+    TTimer  timer( REAL_TIME );
+
+    {
+        const unsigned int  stride[] = { 1, ThreadPool::CACHE_LINE_SIZE / sizeof(long) };
+        const char *        name[]   = { "packed", "padded" };
+        ThreadPool::TPool   pool( max_threads );
+
+        for ( int  v = 0; v < 2; v++ )
+        {
+            std::vector< long >  counters( ( max_threads + 1 ) * stride[1], 0 );
+
+            timer.start();
+
+            for ( int i = 0; i < max_threads; i++ )
+                pool.run( new TWorkerCounterJob( & counters[0], stride[v], count ), NULL, true );
+
+            pool.sync_all();
+        
+            timer.stop();
+            std::cout << "per-worker counters (" << max_threads << " threads, " << name[v] << ") = "
+                      << timer << std::endl;
+        }// for
+    }
+
+    std::vector< TBench2Job * >  jobs( job_count );
+    
+    for ( int i = 0; i < job_count; i++ )
+        jobs[i] = new TBench2Job( i );
+
+    for ( int  thr_count = 1; thr_count <= max_threads; thr_count *= 2 )
+    {
+        ThreadPool::TPool  pool( thr_count );
+
+        timer.start();
+
+        for ( int i = 0; i < job_count; i++ )
+            pool.run( jobs[i] );
+
+        for ( int i = 0; i < job_count; i++ )
+            pool.sync( jobs[i] );
+        
+        timer.stop();
+        std::cout << "run/sync of " << job_count << " jobs (" << thr_count << " threads) = " << timer
+                  << " (" << 1e6 * timer.diff() / job_count << " us per job)" << std::endl;
+    }// for
+
+    for ( int i = 0; i < job_count; i++ )
+        delete jobs[i];
+}
+
+//
+// parallel sorting compared to std::sort and std::stable_sort
+//
+void
+bench6 ( int argc, char ** argv )
+{
+    int   thr_count = ThreadPool::available_cpus();
+    long  max_size  = 10000000;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) max_size  = atol( argv[2] );
+
+    ThreadPool::TPool    pool( thr_count );
+    TTimer               timer( REAL_TIME );
+    TRNG                 rng;
+
+    for ( long  n = 1000000; n <= max_size; n *= 10 )
+    {
+        std::vector< double >  data( n ), ref, tmp;
+
+        for ( long  i = 0; i < n; i++ )
+            data[i] = rng.rand( 1.0 );
+
+        ref = data;
+        timer.start();
+        std::sort( ref.begin(), ref.end() );
+        timer.stop();
+        std::cout << "n = " << n << " : std::sort         = " << timer << std::endl;
+
+        tmp = data;
+        timer.start();
+        ThreadPool::algorithms::sort( pool, tmp.begin(), tmp.end() );
+        timer.stop();
+        std::cout << "n = " << n << " : sort              = " << timer
+                  << ( tmp == ref ? "" : " (wrong result)" ) << std::endl;
+
+        tmp = data;
+        timer.start();
+        std::stable_sort( tmp.begin(), tmp.end() );
+        timer.stop();
+        std::cout << "n = " << n << " : std::stable_sort  = " << timer << std::endl;
+
+        tmp = data;
+        timer.start();
+        ThreadPool::algorithms::stable_sort( pool, tmp.begin(), tmp.end() );
+        timer.stop();
+        std::cout << "n = " << n << " : stable_sort       = " << timer
+                  << ( tmp == ref ? "" : " (wrong result)" ) << std::endl;
+    }// for
+}
+
+//
+// pthread based counterparts of synchronisation primitives
+//
+class TPthreadRWLock
+{
+    pthread_rwlock_t  _lock;
+public:
+    TPthreadRWLock  () { pthread_rwlock_init( & _lock, NULL ); }
+    ~TPthreadRWLock () { pthread_rwlock_destroy( & _lock ); }
+
+    void lock_shared   () { pthread_rwlock_rdlock( & _lock ); }
+    void unlock_shared () { pthread_rwlock_unlock( & _lock ); }
+    void lock          () { pthread_rwlock_wrlock( & _lock ); }
+    void unlock        () { pthread_rwlock_unlock( & _lock ); }
+};
+
+class TPosixSemaphore
+{
+    sem_t  _sem;
+public:
+    TPosixSemaphore ( int n ) { sem_init( & _sem, 0, n ); }
+    ~TPosixSemaphore ()       { sem_destroy( & _sem ); }
+
+    void acquire () { sem_wait( & _sem ); }
+    void release () { sem_post( & _sem ); }
+};
+
+class TPthreadBarrier
+{
+    pthread_barrier_t  _barrier;
+public:
+    TPthreadBarrier ( int n ) { pthread_barrier_init( & _barrier, NULL, n ); }
+    ~TPthreadBarrier ()       { pthread_barrier_destroy( & _barrier ); }
+
+    void arrive_and_wait () { pthread_barrier_wait( & _barrier ); }
+};
+
+class TCondLatch
+{
+    ThreadPool::TCondition  _cond;
+    int                     _count;
+public:
+    TCondLatch ( int n ) : _count( n ) {}
+
+    void arrive_and_wait ()
+    {
+        ThreadPool::TScopedLock  lock( _cond );
+
+        if ( --_count == 0 ) _cond.broadcast();
+        else
+        {
+            while ( _count > 0 )
+                _cond.wait();
+        }// else
+    }
+};
+
+//
+// operations on synchronisation primitives
+//
+template < typename T >
+struct TLockOp
+{
+    T     lock;
+    long  counter;
+
+    TLockOp ( int ) : counter( 0 ) {}
+    void operator () ( int ) { lock.lock(); counter++; lock.unlock(); }
+};
+
+template < typename T >
+struct TReadOp
+{
+    T     lock;
+    long  value;
+
+    TReadOp ( int ) : value( 0 ) {}
+    void operator () ( int i )
+    {
+        // one write per 20 reads
+        if ( i % 20 == 0 ) { lock.lock(); value++; lock.unlock(); }
+        else               { lock.lock_shared(); volatile long  v = value; (void) v; lock.unlock_shared(); }
+    }
+};
+
+template < typename T >
+struct TSemOp
+{
+    T     sem;
+    
+    TSemOp ( int n ) : sem( n > 1 ? n / 2 : 1 ) {}
+    void operator () ( int ) { sem.acquire(); sem.release(); }
+};
+
+template < typename T >
+struct TBarrierOp
+{
+    T     barrier;
+    
+    TBarrierOp ( int n ) : barrier( n ) {}
+    void operator () ( int ) { barrier.arrive_and_wait(); }
+};
+
+template < typename T >
+struct TLatchOp
+{
+    std::vector< T * >  latches;
+
+    TLatchOp ( int n ) : latches( 10000 ) { for ( size_t i = 0; i < latches.size(); i++ ) latches[i] = new T( n ); }
+    ~TLatchOp () { for ( size_t i = 0; i < latches.size(); i++ ) delete latches[i]; }
+    void operator () ( int i ) { latches[ i % latches.size() ]->arrive_and_wait(); }
+};
+
+template < typename Op >
+class TSyncJob : public ThreadPool::TPool::TJob
+{
+protected:
+    Op &  _op;
+    int   _n;
+    
+public:
+    TSyncJob ( Op &  op, int  n ) : _op( op ), _n( n ) {}
+
+    virtual void run ( void * ) { for ( int i = 0; i < _n; i++ ) _op( i ); }
+};
+
+template < typename Op >
+float
+time_sync ( ThreadPool::TPool &  pool, int  nthreads, int  n )
+{
+    Op      op( nthreads );
+    TTimer  timer( REAL_TIME );
+    
+    timer.start();
+    
+    for ( int i = 0; i < nthreads; i++ )
+        pool.run( new TSyncJob< Op >( op, n ), NULL, true );
+
+    pool.sync_all();
+    timer.stop();
+
+    return timer.diff();
+}
+
+//
+// synchronisation primitives compared to pthread counterparts
+//
+void
+bench7 ( int argc, char ** argv )
+{
+    int   thr_count = 64;
+    int   n         = 100000;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) n         = atoi( argv[2] );
+
+    ThreadPool::TPool    pool( thr_count );
+
+    for ( int  t = 1; t <= thr_count; t *= 2 )
+    {
+        std::cout << "threads = " << t << std::endl
+                  << "  TSpinLock  = " << time_sync< TLockOp< ThreadPool::TSpinLock > >( pool, t, n ) << "s"
+                  << ", TMutex         = " << time_sync< TLockOp< ThreadPool::TMutex > >( pool, t, n ) << "s" << std::endl
+                  << "  TRWLock    = " << time_sync< TReadOp< ThreadPool::TRWLock > >( pool, t, n ) << "s"
+                  << ", pthread_rwlock = " << time_sync< TReadOp< TPthreadRWLock > >( pool, t, n ) << "s" << std::endl
+                  << "  TSemaphore = " << time_sync< TSemOp< ThreadPool::TSemaphore > >( pool, t, n ) << "s"
+                  << ", sem_t          = " << time_sync< TSemOp< TPosixSemaphore > >( pool, t, n ) << "s" << std::endl
+                  << "  TBarrier   = " << time_sync< TBarrierOp< ThreadPool::TBarrier > >( pool, t, n / 10 ) << "s"
+                  << ", pthread_barrier= " << time_sync< TBarrierOp< TPthreadBarrier > >( pool, t, n / 10 ) << "s" << std::endl
+                  << "  TLatch     = " << time_sync< TLatchOp< ThreadPool::TLatch > >( pool, t, 10000 ) << "s"
+                  << ", TCondition     = " << time_sync< TLatchOp< TCondLatch > >( pool, t, 10000 ) << "s" << std::endl;
+    }// for
+}
+
+//
+// Jacobi sweeps for a 1D stencil, either by all threads with barriers
+// or by new jobs per sweep
+//
+struct TStencil
+{
+    ThreadPool::TPool *    pool;
+    std::vector< double >  a, b;
+    int                    iters;
+};
+
+inline void
+stencil_sweep ( const double *  src, double *  dst, size_t  n,
+                unsigned int  rank, unsigned int  nthreads )
+{
+    const size_t  lo = 1 + ( n - 2 ) * rank / nthreads;
+    const size_t  hi = 1 + ( n - 2 ) * ( rank + 1 ) / nthreads;
+    
+    for ( size_t  i = lo; i < hi; i++ )
+        dst[i] = ( src[i-1] + src[i] + src[i+1] ) / 3.0;
+}
+
+void
+stencil_spmd ( const unsigned int  rank, const unsigned int  nthreads, void *  arg )
+{
+    TStencil *  s   = static_cast< TStencil * >( arg );
+    double *    src = & s->a[0];
+    double *    dst = & s->b[0];
+    
+    for ( int  it = 0; it < s->iters; it++ )
+    {
+        stencil_sweep( src, dst, s->a.size(), rank, nthreads );
+        std::swap( src, dst );
+        s->pool->barrier();
+    }// for
+}
+
+void
+barrier_spmd ( const unsigned int, const unsigned int, void *  arg )
+{
+    TStencil *  s = static_cast< TStencil * >( arg );
+    
+    for ( int  it = 0; it < s->iters; it++ )
+        s->pool->barrier();
+}
+
+class TStencilJob : public ThreadPool::TPool::TJob
+{
+protected:
+    const double *  _src;
+    double *        _dst;
+    size_t          _n;
+    unsigned int    _rank, _nthreads;
+    
+public:
+    TStencilJob ( const double *  src, double *  dst, size_t  n, unsigned int  rank, unsigned int  nthreads )
+            : _src( src ), _dst( dst ), _n( n ), _rank( rank ), _nthreads( nthreads )
+    {}
+
+    virtual void run ( void * ) { stencil_sweep( _src, _dst, _n, _rank, _nthreads ); }
+};
+
+void
+bench8 ( int argc, char ** argv )
+{
+    int   thr_count = ThreadPool::available_cpus();
+    int   size      = 10000;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) size      = atoi( argv[2] );
+
+    ThreadPool::TPool    pool( thr_count );
+    TTimer               timer( REAL_TIME );
+    TStencil             stencil;
+
+    stencil.pool  = & pool;
+    stencil.iters = 10000;
+    stencil.a.resize( std::max( size, 3 ), 1.0 );
+    stencil.b = stencil.a;
+
+    timer.start();
+    pool.run_on_all( stencil_spmd, & stencil );
+    timer.stop();
+    std::cout << "run_on_all with barrier : " << timer << " ("
+              << 1e6 * timer.diff() / stencil.iters << " us per sweep)" << std::endl;
+
+    timer.start();
+    
+    for ( int  it = 0; it < stencil.iters; it++ )
+    {
+        const double *  src = & ( it % 2 == 0 ? stencil.a : stencil.b )[0];
+        double *        dst = & ( it % 2 == 0 ? stencil.b : stencil.a )[0];
+        
+        for ( int  i = 0; i < thr_count; i++ )
+            pool.run( new TStencilJob( src, dst, stencil.a.size(), i, thr_count ), NULL, true );
+
+        pool.sync_all();
+    }// for
+    
+    timer.stop();
+    std::cout << "jobs with sync_all      : " << timer << " ("
+              << 1e6 * timer.diff() / stencil.iters << " us per sweep)" << std::endl;
+
+    timer.start();
+    pool.run_on_all( barrier_spmd, & stencil );
+    timer.stop();
+    std::cout << "barrier only            : " << timer << " ("
+              << 1e6 * timer.diff() / stencil.iters << " us per barrier)" << std::endl;
+}
+
+//
+// job working for a fixed time, counting missed deadlines of urgent jobs
+//
+class TDeadlineJob : public ThreadPool::TPool::TJob
+{
+protected:
+    double         _work;
+    bool           _urgent;
+    volatile int * _urgent_misses;
+    
+public:
+    TDeadlineJob ( double  work, bool  urgent, volatile int *  urgent_misses )
+            : _work( work ), _urgent( urgent ), _urgent_misses( urgent_misses )
+    {}
+
+    virtual void run ( void * )
+    {
+        const double  end = ThreadPool::monotonic_time() + _work;
+
+        while ( ThreadPool::monotonic_time() < end )
+            ;
+
+        if ( _urgent && ( ThreadPool::monotonic_time() > deadline() ))
+            ThreadPool::atomic_add( *_urgent_misses, 1 );
+    }
+};
+
+//
+// deadline misses of FIFO and EDF scheduling in an overloaded pool
+//
+void
+bench9 ( int argc, char ** argv )
+{
+    int     thr_count = ThreadPool::available_cpus();
+    double  load      = 1.1;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) load      = atof( argv[2] );
+
+    const double  work     = 0.0002;  // time per job
+    const double  interval = 0.01;    // time between bursts of jobs
+    const int     bursts   = 100;
+    const int     burst    = int( load * thr_count * interval / work );
+    const char *  name[]   = { "FIFO", "EDF " };
+    TRNG          rng;
+
+    for ( int  m = 0; m < 2; m++ )
+    {
+        ThreadPool::TPool  pool( thr_count );
+        volatile int       urgent_misses = 0;
+        int                urgent        = 0;
+
+        pool.set_schedule( m == 0 ? ThreadPool::TPool::SCHEDULE_FIFO : ThreadPool::TPool::SCHEDULE_EDF );
+        
+        for ( int  b = 0; b < bursts; b++ )
+        {
+            const double  now = ThreadPool::monotonic_time();
+            
+            for ( int  i = 0; i < burst; i++ )
+            {
+                // every fifth job is urgent
+                const bool      is_urgent = ( rng.rand( 1.0 ) < 0.2 );
+                TDeadlineJob *  job       = new TDeadlineJob( work, is_urgent, & urgent_misses );
+
+                job->set_deadline( now + ( is_urgent ? 0.005 : 0.05 ) );
+                urgent += ( is_urgent ? 1 : 0 );
+                pool.run( job, NULL, true );
+            }// for
+
+            usleep( int( 1e6 * interval ) );
+        }// for
+
+        pool.sync_all();
+
+        const ThreadPool::TPool::TStats  stats = pool.stats();
+        
+        std::cout << name[m] << " : missed " << stats.deadline_misses << " of " << stats.deadline_jobs
+                  << " deadlines (" << 100.0 * stats.deadline_misses / stats.deadline_jobs << "%), urgent "
+                  << urgent_misses << " of " << urgent
+                  << " (" << 100.0 * urgent_misses / std::max( urgent, 1 ) << "%)" << std::endl;
+    }// for
+}
+
+//
+// job working for a fixed time, optionally recording its latency
+//
+class TLatencyJob : public ThreadPool::TPool::TJob
+{
+protected:
+    double                   _work;
+    double                   _submit;
+    double                   _finish;
+    std::vector< double > *  _latency;
+    ThreadPool::TMutex *     _mutex;
+    
+public:
+    TLatencyJob ( double  work, std::vector< double > *  latency, ThreadPool::TMutex *  mutex )
+            : _work( work ), _submit( ThreadPool::monotonic_time() ), _finish( 0.0 ),
+              _latency( latency ), _mutex( mutex )
+    {}
+
+    virtual void run ( void * )
+    {
+        const double  end = ThreadPool::monotonic_time() + _work;
+
+        while ( ThreadPool::monotonic_time() < end )
+            ;
+
+        _finish = ThreadPool::monotonic_time();
+        
+        if ( _latency != NULL )
+        {
+            ThreadPool::TScopedLock  lock( * _mutex );
+            
+            _latency->push_back( ThreadPool::monotonic_time() - _submit );
+        }// if
+    }
+
+    double  finished () const { return _finish; }
+};
+
+//
+// latency of light tenant without and with flooding heavy tenant
+// for FIFO and fair scheduling
+//
+void
+bench10 ( int argc, char ** argv )
+{
+    int   thr_count = ThreadPool::available_cpus();
+    int   nheavy    = 2000;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) nheavy    = atoi( argv[2] );
+
+    const double  work   = 0.0001;
+    const int     nlight = 100;
+    const char *  name[] = { "light only   ", "FIFO (heavy) ", "FAIR (heavy) " };
+
+    for ( int  m = 0; m < 3; m++ )
+    {
+        ThreadPool::TPool      pool( thr_count );
+        const unsigned int     heavy = pool.add_tenant( 1 );
+        const unsigned int     light = pool.add_tenant( 1 );
+        std::vector< double >  latency;
+        ThreadPool::TMutex     mutex;
+
+        if ( m == 2 )
+            pool.set_schedule( ThreadPool::TPool::SCHEDULE_FAIR );
+
+        if ( m > 0 )
+        {
+            for ( int  i = 0; i < nheavy * thr_count; i++ )
+            {
+                TLatencyJob *  job = new TLatencyJob( work, NULL, NULL );
+
+                job->set_tenant( heavy );
+                pool.run( job, NULL, true );
+            }// for
+        }// if
+
+        for ( int  i = 0; i < nlight; i++ )
+        {
+            TLatencyJob *  job = new TLatencyJob( work, & latency, & mutex );
+
+            job->set_tenant( light );
+            pool.run( job, NULL, true );
+            usleep( 1000 );
+        }// for
+
+        pool.sync_all();
+        std::sort( latency.begin(), latency.end() );
+
+        std::cout << name[m] << " : latency of light jobs p50 = " << 1e3 * latency[ latency.size() / 2 ]
+                  << " ms, p99 = " << 1e3 * latency[ ( latency.size() * 99 ) / 100 ]
+                  << " ms, max = " << 1e3 * latency.back() << " ms" << std::endl;
+    }// for
+}
+
+//
+// job waiting for simulated I/O, optionally in a blocking region
+//
+class TIOJob : public ThreadPool::TPool::TJob
+{
+protected:
+    int   _usec;
+    bool  _region;
+    
+public:
+    TIOJob ( int  usec, bool  region ) : _usec( usec ), _region( region ) {}
+
+    virtual void run ( void * )
+    {
+        if ( _region )
+        {
+            ThreadPool::TPool::TBlockingRegion  region;
+            
+            usleep( _usec );
+        }// if
+        else
+            usleep( _usec );
+    }
+};
+
+//
+// runtime of CPU bound jobs mixed with blocking jobs without and with
+// blocking regions
+//
+void
+bench11 ( int argc, char ** argv )
+{
+    int   thr_count = ThreadPool::available_cpus();
+    int   njobs     = 4000;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) njobs     = atoi( argv[2] );
+
+    const char *  name[] = { "plain   ", "blocking" };
+
+    for ( int  m = 0; m < 2; m++ )
+    {
+        ThreadPool::TPool  pool( thr_count );
+        TTimer             timer( REAL_TIME );
+
+        timer.start();
+        
+        for ( int  i = 0; i < njobs; i++ )
+        {
+            // every tenth job waits for 5ms
+            if ( i % 10 == 0 )
+                pool.run( new TIOJob( 5000, m == 1 ), NULL, true );
+            else
+                pool.run( new TLatencyJob( 0.0002, NULL, NULL ), NULL, true );
+        }// for
+
+        pool.sync_all();
+        timer.stop();
+
+        std::cout << name[m] << " : " << timer << " (" << pool.stats().blocking_regions
+                  << " blocking regions)" << std::endl;
+    }// for
+}
+
+//
+// runtime and context switches of three fully sized pools with
+// CPU bound jobs without and with shared thread budget
+//
+void
+bench12 ( int argc, char ** argv )
+{
+    int   thr_count = ThreadPool::available_cpus();
+    int   njobs     = 2000;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) njobs     = atoi( argv[2] );
+
+    const char *  name[] = { "independent", "budget     " };
+
+    for ( int  m = 0; m < 2; m++ )
+    {
+        ThreadPool::TThreadBudget  budget( thr_count );
+        ThreadPool::TPool          compute( thr_count ), io( thr_count ), background( thr_count );
+        ThreadPool::TPool *        pools[] = { & compute, & io, & background };
+        TTimer                     timer( REAL_TIME );
+        struct rusage              start, stop;
+
+        if ( m == 1 )
+        {
+            compute.set_budget( & budget, 1 );
+            io.set_budget( & budget, 1 );
+            background.set_budget( & budget, 0 );
+        }// if
+        
+        getrusage( RUSAGE_SELF, & start );
+        timer.start();
+        
+        for ( int  i = 0; i < njobs * thr_count; i++ )
+            pools[ i % 3 ]->run( new TBenchJob( i, 100 ), NULL, true );
+
+        for ( int  i = 0; i < 3; i++ )
+            pools[i]->sync_all();
+        
+        timer.stop();
+        getrusage( RUSAGE_SELF, & stop );
+
+        std::cout << name[m] << " : " << timer << ", "
+                  << ( stop.ru_nvcsw + stop.ru_nivcsw ) - ( start.ru_nvcsw + start.ru_nivcsw )
+                  << " context switches" << std::endl;
+
+        for ( int  i = 0; i < 3; i++ )
+            pools[i]->shutdown();
+    }// for
+}
+
+//
+// runtime of jobs with mixed sizes (as in bench1) in an oversized pool
+// with fixed and auto-tuned number of active threads
+//
+void
+bench13 ( int argc, char ** argv )
+{
+    int   thr_count = 4 * ThreadPool::available_cpus();
+    int   njobs     = 4096;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) njobs     = atoi( argv[2] );
+
+    const char *  name[] = { "fixed     ", "auto-tuned" };
+
+    for ( int  m = 0; m < 2; m++ )
+    {
+        ThreadPool::TPool  pool( thr_count );
+        TTimer             timer( REAL_TIME );
+        TRNG               rng;
+
+        if ( m == 1 )
+            pool.set_auto_tune( true, 1, thr_count, 0.05 );
+        
+        timer.start();
+        
+        for ( int  i = 0; i < njobs; i++ )
+            pool.run( new TBenchJob( i, int( rng.rand( MAX_RAND )) + MAX_SIZE ), NULL, true );
+
+        pool.sync_all();
+        timer.stop();
+
+        const ThreadPool::TPool::TStats  stats = pool.stats();
+        
+        std::cout << name[m] << " : " << timer << ", " << stats.active_limit << " active threads ("
+                  << stats.tune_increases << " increases, " << stats.tune_decreases << " decreases)" << std::endl;
+    }// for
+}
+
+//
+// mean delay between finishing and handling of results with sync in
+// order of submission and with completion queue (first job is slow)
+//
+void
+bench14 ( int argc, char ** argv )
+{
+    int   thr_count = ThreadPool::available_cpus();
+    int   njobs     = 2000;
+    
+    if ( argc > 1 ) thr_count = atoi( argv[1] );
+    if ( argc > 2 ) njobs     = atoi( argv[2] );
+
+    const char *  name[] = { "sync in order   ", "completion queue" };
+
+    for ( int  m = 0; m < 2; m++ )
+    {
+        ThreadPool::TPool                           pool( thr_count );
+        ThreadPool::TCompletionQueue                cq;
+        std::vector< ThreadPool::TPool::TJob * >    jobs( njobs );
+        double                                      delay = 0.0;
+
+        if ( m == 1 )
+            pool.set_completion_queue( & cq );
+        
+        for ( int  i = 0; i < njobs; i++ )
+        {
+            jobs[i] = new TLatencyJob( i == 0 ? 0.05 : 0.0001, NULL, NULL );
+            pool.run( jobs[i] );
+        }// for
+
+        for ( int  i = 0; i < njobs; i++ )
+        {
+            ThreadPool::TPool::TJob *  job;
+            
+            if ( m == 0 )
+            {
+                job = jobs[i];
+                pool.sync( job );
+            }// if
+            else
+                job = cq.wait_one();
+
+            // time between finishing of job and handling of result
+            delay += ThreadPool::monotonic_time() - static_cast< TLatencyJob * >( job )->finished();
+        }// for
+
+        std::cout << name[m] << " : mean delay until result is handled = "
+                  << 1e3 * delay / njobs << " ms" << std::endl;
+        
+        for ( int  i = 0; i < njobs; i++ )
+            delete jobs[i];
+    }// for
+}
+
 int
 main ( int argc, char ** argv )
 {
     // bench1( argc, argv );
     bench2( argc, argv );
+    // bench3( argc, argv );
+    // bench4( argc, argv );
+    // bench5( argc, argv );
+    // bench6( argc, argv );
+    // bench7( argc, argv );
+    // bench8( argc, argv );
+    // bench9( argc, argv );
+    // bench10( argc, argv );
+    // bench11( argc, argv );
+    // bench12( argc, argv );
+    // bench13( argc, argv );
+    // bench14( argc, argv );
 }